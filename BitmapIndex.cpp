@@ -0,0 +1,195 @@
+#include "BitmapIndex.h"
+
+#include <QAbstractItemModel>
+#include <algorithm>
+#include <iterator>
+
+bool RowBitmap::Chunk::contains(quint16 low) const
+{
+	if (!bits.empty()) {
+		return bits[low / 64] & (quint64(1) << (low % 64));
+	}
+	return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RowBitmap::Chunk::toBits()
+{
+	if (!bits.empty()) {
+		return;
+	}
+	bits.assign(kWords, 0);
+	for (quint16 low : array) {
+		bits[low / 64] |= quint64(1) << (low % 64);
+	}
+	array.clear();
+	array.shrink_to_fit();
+}
+
+void RowBitmap::add(unsigned row)
+{
+	const quint16 key = row >> 16;
+	const quint16 low = row & 0xffff;
+	if (_chunks.empty() || _chunks.back().key != key) {
+		_chunks.push_back(Chunk());
+		_chunks.back().key = key;
+	}
+	Chunk &chunk = _chunks.back();
+	if (chunk.bits.empty()) {
+		chunk.array.push_back(low);
+		if (chunk.array.size() > kArrayMax) {
+			chunk.toBits();
+		}
+	} else {
+		chunk.bits[low / 64] |= quint64(1) << (low % 64);
+	}
+}
+
+bool RowBitmap::contains(unsigned row) const
+{
+	const quint16 key = row >> 16;
+	auto chunk = std::lower_bound(
+		_chunks.begin(), _chunks.end(), key,
+		[](const Chunk &c, quint16 key) { return c.key < key; });
+	return chunk != _chunks.end() && chunk->key == key
+	       && chunk->contains(row & 0xffff);
+}
+
+void RowBitmap::unite(const RowBitmap &other)
+{
+	std::vector<Chunk> chunks;
+	auto a = _chunks.begin();
+	auto b = other._chunks.begin();
+	while (a != _chunks.end() || b != other._chunks.end()) {
+		if (b == other._chunks.end()
+		    || (a != _chunks.end() && a->key < b->key)) {
+			chunks.push_back(std::move(*a++));
+		} else if (a == _chunks.end() || b->key < a->key) {
+			chunks.push_back(*b++);
+		} else {
+			Chunk chunk;
+			chunk.key = a->key;
+			if (a->bits.empty() && b->bits.empty()
+			    && a->array.size() + b->array.size() <= kArrayMax) {
+				std::set_union(a->array.begin(), a->array.end(),
+					       b->array.begin(), b->array.end(),
+					       std::back_inserter(chunk.array));
+			} else {
+				chunk = std::move(*a);
+				chunk.toBits();
+				if (b->bits.empty()) {
+					for (quint16 low : b->array) {
+						chunk.bits[low / 64] |= quint64(1)
+									<< (low % 64);
+					}
+				} else {
+					for (unsigned w = 0; w < kWords; w++) {
+						chunk.bits[w] |= b->bits[w];
+					}
+				}
+			}
+			chunks.push_back(std::move(chunk));
+			++a;
+			++b;
+		}
+	}
+	_chunks.swap(chunks);
+}
+
+void RowBitmap::intersect(const RowBitmap &other)
+{
+	std::vector<Chunk> chunks;
+	auto a = _chunks.begin();
+	auto b = other._chunks.begin();
+	while (a != _chunks.end() && b != other._chunks.end()) {
+		if (a->key < b->key) {
+			++a;
+		} else if (b->key < a->key) {
+			++b;
+		} else {
+			Chunk chunk;
+			chunk.key = a->key;
+			if (!a->bits.empty() && !b->bits.empty()) {
+				chunk.bits.resize(kWords);
+				for (unsigned w = 0; w < kWords; w++) {
+					chunk.bits[w] = a->bits[w] & b->bits[w];
+				}
+			} else {
+				// every row of the array is looked up in the other chunk
+				const Chunk &sparse = a->bits.empty() ? *a : *b;
+				const Chunk &dense = a->bits.empty() ? *b : *a;
+				for (quint16 low : sparse.array) {
+					if (dense.contains(low)) {
+						chunk.array.push_back(low);
+					}
+				}
+			}
+			const bool empty =
+				chunk.array.empty()
+				&& std::all_of(chunk.bits.begin(), chunk.bits.end(),
+					       [](quint64 word) { return word == 0; });
+			if (!empty) {
+				chunks.push_back(std::move(chunk));
+			}
+			++a;
+			++b;
+		}
+	}
+	_chunks.swap(chunks);
+}
+
+void RowBitmap::mask(std::vector<char> &rows) const
+{
+	std::vector<char> in(rows.size(), 0);
+	for (const Chunk &chunk : _chunks) {
+		const size_t base = size_t(chunk.key) << 16;
+		if (chunk.bits.empty()) {
+			for (quint16 low : chunk.array) {
+				if (base + low < in.size()) {
+					in[base + low] = 1;
+				}
+			}
+			continue;
+		}
+		for (unsigned w = 0; w < kWords; w++) {
+			const quint64 word = chunk.bits[w];
+			for (unsigned bit = 0; word && bit < 64; bit++) {
+				const size_t row = base + w * 64 + bit;
+				if ((word >> bit & 1) && row < in.size()) {
+					in[row] = 1;
+				}
+			}
+		}
+	}
+	for (size_t row = 0; row < rows.size(); row++) {
+		rows[row] &= in[row];
+	}
+}
+
+bool BitmapIndex::build(const QAbstractItemModel &model, int col)
+{
+	clear();
+	_built = true;
+	const int rowCount = model.rowCount();
+	for (int row = 0; row < rowCount; row++) {
+		RowBitmap &rows =
+			_values[model.data(model.index(row, col)).toString()];
+		rows.add(row);
+		if (_values.size() > kMaxValues) {
+			_values.clear();
+			return false;
+		}
+	}
+	_indexable = true;
+	return true;
+}
+
+RowBitmap BitmapIndex::rows(const QRegularExpression &re, bool notMatch) const
+{
+	RowBitmap rows;
+	for (auto value = _values.begin(); value != _values.end(); ++value) {
+		if (value.key().contains(re) != notMatch) {
+			rows.unite(value.value());
+		}
+	}
+	return rows;
+}
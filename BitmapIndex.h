@@ -0,0 +1,75 @@
+#ifndef BITMAPINDEX_H
+#define BITMAPINDEX_H
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QString>
+#include <vector>
+
+class QAbstractItemModel;
+
+//Set of rows split into chunks of 65536 like a roaring bitmap: a sparse
+//chunk is a sorted array of the low 16 bits, a dense one 1024 words of bits.
+class RowBitmap
+{
+public:
+	//rows are added in increasing order
+	void add(unsigned row);
+	bool contains(unsigned row) const;
+	bool isEmpty() const
+	{
+		return _chunks.empty();
+	}
+	void unite(const RowBitmap& other);
+	void intersect(const RowBitmap& other);
+	//clears the rows that aren't in the set
+	void mask(std::vector<char>& rows) const;
+
+private:
+	static const unsigned kArrayMax=4096;//above it a chunk takes less room as bits
+	static const unsigned kWords=1024;
+	struct Chunk
+	{
+		quint16 key;//high 16 bits of the rows
+		std::vector<quint16> array;//sorted, if bits is empty
+		std::vector<quint64> bits;
+		bool contains(quint16 low) const;
+		void toBits();
+	};
+	std::vector<Chunk> _chunks;//sorted by key
+};
+
+//A bitmap of rows per value of a text column with a few dozen values. Any
+//match or notMatch filter of the column is answered exactly by running it
+//over the values and joining their bitmaps.
+class BitmapIndex
+{
+public:
+	static const int kMaxValues=64;
+
+	//false if the column has too many values to be indexed
+	bool build(const QAbstractItemModel& model, int col);
+	void clear()
+	{
+		_values.clear();
+		_built=false;
+		_indexable=false;
+	}
+	bool isBuilt() const
+	{
+		return _built;
+	}
+	bool isIndexable() const
+	{
+		return _indexable;
+	}
+	//rows whose value contains the pattern, or doesn't if notMatch
+	RowBitmap rows(const QRegularExpression& re, bool notMatch=false) const;
+
+private:
+	QHash<QString,RowBitmap> _values;
+	bool _built=false;
+	bool _indexable=false;
+};
+
+#endif // BITMAPINDEX_H
@@ -14,7 +14,7 @@ int BlackHolesTableModel::rowCount(const QModelIndex &parent) const
 
 int BlackHolesTableModel::columnCount(const QModelIndex &parent) const
 {
-    return 6;
+    return 8;
 }
 
 QVariant BlackHolesTableModel::data(const QModelIndex &index, int role) const
@@ -28,28 +28,39 @@ QVariant BlackHolesTableModel::data(const QModelIndex &index, int role) const
         case 0:
             return _galaxy->blackHoleStar1(row);
         case 1:
-            return std::round(_galaxy->blackHoleStar1Distance(row)*10.0)*0.1;
+            return std::round(_galaxy->blackHoleStar1Distance(row,_galaxy->referenceStarId(_referenceStar))*10.0)*0.1;
         case 2:
             return _galaxy->blackHoleStar2(row);
         case 3:
-            return std::round(_galaxy->blackHoleStar2Distance(row)*10.0)*0.1;
+            return std::round(_galaxy->blackHoleStar2Distance(row,_galaxy->referenceStarId(_referenceStar))*10.0)*0.1;
         case 4:
             return _galaxy->blackHoleTurnsToClose(row);
         case 5:
             return _galaxy->blackHoleNextLootChange(row);
+        case 6:
+            return std::round(_galaxy->routeDistance(_galaxy->referenceStarId(_referenceStar),_galaxy->blackHoleStar1Id(row))*10.0)*0.1;
+        case 7:
+            return std::round(_galaxy->routeDistance(_galaxy->referenceStarId(_referenceStar),_galaxy->blackHoleStar2Id(row))*10.0)*0.1;
         default:
             return QVariant();
         }
 
         return index.row()+index.column();
     }
+    if (role == Qt::ToolTipRole && index.column()>5)
+    {
+        const unsigned starId=index.column()==6 ? _galaxy->blackHoleStar1Id(index.row())
+                                                : _galaxy->blackHoleStar2Id(index.row());
+        return _galaxy->routeText(_galaxy->referenceStarId(_referenceStar),starId);
+    }
     return QVariant();
 }
 
 QVariant BlackHolesTableModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     static const QVector<QString> header={tr("Star 1"),tr("Dist."),tr("Star 2"),
-                                          tr("Dist."), tr("Days left"),tr("Next loot change")};
+                                          tr("Dist."), tr("Days left"),tr("Next loot change"),
+                                          tr("Route 1"),tr("Route 2")};
     if (role == Qt::DisplayRole)
     {
         if (orientation == Qt::Vertical)
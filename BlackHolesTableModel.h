@@ -16,6 +16,15 @@ public:
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    //both Dist. and Route columns, the black holes are measured from this star
+    void setReferenceStar(int starId)
+    {
+        _referenceStar=starId;
+        if(rowCount()>0) {
+            emit dataChanged(index(0,1),index(rowCount()-1,3));
+            emit dataChanged(index(0,6),index(rowCount()-1,7));
+        }
+    }
     void reload()
     {
         beginResetModel();
@@ -27,6 +36,7 @@ signals:
 public slots:
 private:
     const Galaxy *_galaxy;
+    int _referenceStar=-1;
 };
 
 #endif // BLACKHOLESTABLEMODEL_H
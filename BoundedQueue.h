@@ -0,0 +1,83 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <deque>
+
+//Blocking FIFO with a fixed capacity, connects the stages of a pipeline.
+//push() waits while the queue is full, which slows the producer down to the
+//speed of the consumer. After close() pushes fail and pop() drains the rest.
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(int capacity) : _capacity(capacity)
+	{
+	}
+	bool push(T item)
+	{
+		QMutexLocker locker(&_mutex);
+		while (int(_items.size()) >= _capacity && !_closed) {
+			_notFull.wait(&_mutex);
+		}
+		if (_closed) {
+			return false;
+		}
+		_items.push_back(std::move(item));
+		_notEmpty.wakeOne();
+		return true;
+	}
+	//does not wait, false if the queue is full or closed
+	bool tryPush(T item)
+	{
+		QMutexLocker locker(&_mutex);
+		if (_closed || int(_items.size()) >= _capacity) {
+			return false;
+		}
+		_items.push_back(std::move(item));
+		_notEmpty.wakeOne();
+		return true;
+	}
+	bool pop(T &item)
+	{
+		QMutexLocker locker(&_mutex);
+		while (_items.empty() && !_closed) {
+			_notEmpty.wait(&_mutex);
+		}
+		if (_items.empty()) {
+			return false;
+		}
+		item = std::move(_items.front());
+		_items.pop_front();
+		_notFull.wakeOne();
+		return true;
+	}
+	void close()
+	{
+		QMutexLocker locker(&_mutex);
+		_closed = true;
+		_notEmpty.wakeAll();
+		_notFull.wakeAll();
+	}
+	int size() const
+	{
+		QMutexLocker locker(&_mutex);
+		return int(_items.size());
+	}
+	int capacity() const
+	{
+		return _capacity;
+	}
+
+private:
+	const int _capacity;
+	bool _closed = false;
+	std::deque<T> _items;
+	mutable QMutex _mutex;
+	QWaitCondition _notEmpty;
+	QWaitCondition _notFull;
+};
+
+#endif // BOUNDEDQUEUE_H
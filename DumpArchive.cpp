@@ -0,0 +1,214 @@
+#include "DumpArchive.h"
+
+#include <QDataStream>
+
+namespace
+{
+const quint32 kMagic = 0x53524441; // SRDA
+const quint32 kFormat = 1;
+
+void indexBlocks(const QStringList &blocks, QHash<QString, int> &index)
+{
+	index.clear();
+	index.reserve(blocks.size());
+	for (int i = 0; i < blocks.size(); i++) {
+		index.insert(blocks[i], i);
+	}
+}
+} // namespace
+
+QStringList DumpArchive::blocks(const QString &dump)
+{
+	QStringList blocks;
+	int depth = 0;
+	bool inStarList = false;
+	int begin = 0;
+	int lineBegin = 0;
+	while (lineBegin < dump.size()) {
+		int lineEnd = dump.indexOf('\n', lineBegin);
+		lineEnd = lineEnd < 0 ? dump.size() : lineEnd + 1;
+		const QStringRef line = dump.midRef(lineBegin, lineEnd - lineBegin);
+		const QStringRef trimmed = line.trimmed();
+		// the records start at the top level, the stars inside StarList
+		const bool starts =
+			depth == 0
+			|| (inStarList && depth == 1 && trimmed.startsWith("StarId"));
+		if (starts && lineBegin > begin) {
+			blocks << dump.mid(begin, lineBegin - begin);
+			begin = lineBegin;
+		}
+		if (depth == 0 && trimmed == QLatin1String("StarList ^{")) {
+			inStarList = true;
+		}
+		depth += line.count('{') - line.count('}');
+		if (depth <= 0) {
+			depth = 0;
+			inStarList = false;
+		}
+		lineBegin = lineEnd;
+	}
+	if (begin < dump.size()) {
+		blocks << dump.mid(begin);
+	}
+	return blocks;
+}
+
+bool DumpArchive::open(const QString &fileName, OpenMode mode)
+{
+	close();
+	_file.setFileName(fileName);
+	if (!_file.open(mode == kReadOnly ? QIODevice::ReadOnly
+					  : QIODevice::ReadWrite)) {
+		return false;
+	}
+	QDataStream stream(&_file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	if (_file.size() == 0 && mode == kReadOnly) {
+		_file.close();
+		return false;
+	}
+	if (_file.size() == 0) {
+		stream << kMagic << kFormat;
+		return stream.status() == QDataStream::Ok;
+	}
+	quint32 magic, format;
+	stream >> magic >> format;
+	if (magic != kMagic || format != kFormat) {
+		_file.close();
+		return false;
+	}
+	qint64 end = _file.pos();
+	for (;;) {
+		Version version;
+		stream >> version.keyframe >> version.name >> version.size;
+		version.offset = _file.pos();
+		if (stream.status() != QDataStream::Ok
+		    || version.offset + version.size > _file.size()) {
+			break;
+		}
+		_file.seek(version.offset + version.size);
+		end = _file.pos();
+		_versions.push_back(version);
+	}
+	if (mode == kReadOnly) {
+		// the versions are read, the tail cut short is left alone
+		return true;
+	}
+	// a version cut short is dropped, the next one is written over it
+	_file.resize(end);
+	_file.seek(end);
+	// the blocks of the last version for the next delta
+	QString last;
+	if (!_versions.empty() && !read(count() - 1, last)) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void DumpArchive::close()
+{
+	_file.close();
+	_versions.clear();
+	_lastBlocks.clear();
+	_lastIndex.clear();
+}
+
+bool DumpArchive::append(const QString &dump, const QString &name)
+{
+	if (!_file.isWritable()) {
+		return false;
+	}
+	const QStringList blocks = DumpArchive::blocks(dump);
+	if (blocks == _lastBlocks) {
+		return false;
+	}
+	Version version;
+	version.name = name;
+	version.keyframe = count() % kKeyframeInterval == 0;
+	// a block is either the index of the same block of the version
+	// before or -1 followed by its text
+	QByteArray data;
+	QDataStream blockStream(&data, QIODevice::WriteOnly);
+	blockStream.setVersion(QDataStream::Qt_5_0);
+	blockStream << quint32(blocks.size());
+	for (const QString &block : blocks) {
+		const int same = version.keyframe ? -1 : _lastIndex.value(block, -1);
+		blockStream << qint32(same);
+		if (same < 0) {
+			blockStream << block.toUtf8();
+		}
+	}
+	const QByteArray compressed = qCompress(data);
+	version.size = compressed.size();
+
+	QDataStream stream(&_file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << version.keyframe << version.name << version.size;
+	version.offset = _file.pos();
+	if (stream.writeRawData(compressed.constData(), compressed.size())
+		    != compressed.size()
+	    || !_file.flush()) {
+		return false;
+	}
+	_versions.push_back(version);
+	_lastBlocks = blocks;
+	indexBlocks(_lastBlocks, _lastIndex);
+	return true;
+}
+
+bool DumpArchive::decode(const Version &version, QStringList &blocks)
+{
+	if (!_file.seek(version.offset)) {
+		return false;
+	}
+	const QByteArray data = qUncompress(_file.read(version.size));
+	QDataStream stream(data);
+	stream.setVersion(QDataStream::Qt_5_0);
+	quint32 count;
+	stream >> count;
+	QStringList decoded;
+	decoded.reserve(count);
+	for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok;
+	     i++) {
+		qint32 same;
+		stream >> same;
+		if (same < 0) {
+			QByteArray text;
+			stream >> text;
+			decoded << QString::fromUtf8(text);
+		} else if (same < blocks.size()) {
+			decoded << blocks[same];
+		} else {
+			return false;
+		}
+	}
+	blocks.swap(decoded);
+	return stream.status() == QDataStream::Ok;
+}
+
+bool DumpArchive::read(int version, QString &dump)
+{
+	if (version < 0 || version >= count()) {
+		return false;
+	}
+	int keyframe = version;
+	while (keyframe > 0 && !_versions[keyframe].keyframe) {
+		keyframe--;
+	}
+	QStringList blocks;
+	bool ok = true;
+	for (int v = keyframe; v <= version && ok; v++) {
+		ok = decode(_versions[v], blocks);
+	}
+	_file.seek(_file.size());
+	if (!ok) {
+		return false;
+	}
+	if (version == count() - 1) {
+		_lastBlocks = blocks;
+		indexBlocks(_lastBlocks, _lastIndex);
+	}
+	dump = blocks.join(QString());
+	return true;
+}
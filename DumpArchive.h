@@ -0,0 +1,68 @@
+#ifndef DUMPARCHIVE_H
+#define DUMPARCHIVE_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+//Successive dumps of one session in one file. A dump is cut into the blocks
+//Galaxy::parseDump() reads: the Player and HoleList records, every star of
+//the StarList with its planets, ships and items, and the loose lines between
+//them. Every kKeyframeInterval-th version stores all its blocks, the others
+//only the blocks that differ from the version before and the index of the
+//unchanged ones; each version is compressed with zlib. Reading a version
+//replays the deltas from the keyframe before it.
+class DumpArchive
+{
+public:
+	static const int kKeyframeInterval=16;
+
+	enum OpenMode {kAppend, kReadOnly};
+	//opens or creates the archive, an archive cut short by a crash keeps
+	//its complete versions; kReadOnly neither creates nor cuts the file,
+	//and append() fails
+	bool open(const QString& fileName, OpenMode mode=kAppend);
+	void close();
+	bool isOpen() const
+	{
+		return _file.isOpen();
+	}
+	QString fileName() const
+	{
+		return _file.fileName();
+	}
+	//adds a dump unless it is the same as the last one
+	bool append(const QString& dump, const QString& name);
+	int count() const
+	{
+		return _versions.size();
+	}
+	QString name(int version) const
+	{
+		return _versions[version].name;
+	}
+	bool read(int version, QString& dump);
+
+	//the blocks of a dump, they add up to the whole text
+	static QStringList blocks(const QString& dump);
+
+private:
+	struct Version
+	{
+		QString name;
+		bool keyframe;
+		qint64 offset;//of the compressed blocks
+		quint32 size;
+	};
+	//the blocks of a version out of the blocks of the version before
+	bool decode(const Version& version, QStringList& blocks);
+
+	QFile _file;
+	std::vector<Version> _versions;
+	QStringList _lastBlocks;//of the last version
+	QHash<QString,int> _lastIndex;//block -> index in _lastBlocks
+};
+
+#endif // DUMPARCHIVE_H
@@ -0,0 +1,166 @@
+#include "DumpDiff.h"
+#include "Galaxy.h"
+
+#include <QCoreApplication>
+#include <algorithm>
+
+namespace
+{
+template <class T> void sortById(std::vector<T> &v)
+{
+	std::sort(v.begin(), v.end(),
+		  [](const T &a, const T &b) { return a.id < b.id; });
+}
+
+// calls onBoth, onBefore or onAfter for every id of the two sorted arrays
+template <class T, class Key, class Both, class Before, class After>
+void join(const std::vector<T> &before, const std::vector<T> &after, Key key,
+	  Both onBoth, Before onBefore, After onAfter)
+{
+	auto b = before.begin();
+	auto a = after.begin();
+	while (b != before.end() || a != after.end()) {
+		if (a == after.end() || (b != before.end() && key(*b) < key(*a))) {
+			onBefore(*b++);
+		} else if (b == before.end() || key(*a) < key(*b)) {
+			onAfter(*a++);
+		} else {
+			onBoth(*b++, *a++);
+		}
+	}
+}
+
+QString prices(const GoodsArr &sale, const GoodsArr &buy, int good)
+{
+	return QString("%1/%2").arg(sale[good]).arg(buy[good]);
+}
+} // namespace
+
+DumpSnapshot::DumpSnapshot(const Galaxy &galaxy)
+{
+	stars = galaxy.starIndex().ids();
+	std::sort(stars.begin(), stars.end());
+
+	items.reserve(galaxy.equipmentCount());
+	for (unsigned row = 0; row < galaxy.equipmentCount(); row++) {
+		const Equipment &eq = galaxy.equipment(row);
+		items.push_back({eq.id(), eq.locationType(), eq.locationId(),
+				 eq.name(), galaxy.equipmentLocationName(row)});
+	}
+	sortById(items);
+
+	markets.reserve(galaxy.marketsCount());
+	for (unsigned row = 0; row < galaxy.marketsCount(); row++) {
+		markets.push_back({DumpDiff::marketKey(galaxy, row),
+				   galaxy.marketName(row), galaxy.marketSale(row),
+				   galaxy.marketBuy(row)});
+	}
+	std::sort(markets.begin(), markets.end(),
+		  [](const Market &a, const Market &b) { return a.key < b.key; });
+
+	planets.reserve(galaxy.planetCount());
+	for (unsigned row = 0; row < galaxy.planetCount(); row++) {
+		const ::Planet &planet = galaxy.planet(row);
+		planets.push_back({planet.id(), planet.name(),
+				   galaxy.planetOwner(row), planet.techLevel()});
+	}
+	sortById(planets);
+}
+
+quint64 DumpDiff::marketKey(const Galaxy &galaxy, unsigned row)
+{
+	return marketKey(galaxy.marketIsShip(row), galaxy.marketId(row));
+}
+
+QString DumpDiff::kindName(Kind kind)
+{
+	switch (kind) {
+	case kItemAdded:
+		return QCoreApplication::translate("DumpDiff", "Item added");
+	case kItemRemoved:
+		return QCoreApplication::translate("DumpDiff", "Item removed");
+	case kItemMoved:
+		return QCoreApplication::translate("DumpDiff", "Item moved");
+	case kPriceChanged:
+		return QCoreApplication::translate("DumpDiff", "Price");
+	case kOwnerChanged:
+		return QCoreApplication::translate("DumpDiff", "Owner");
+	case kTechLevelChanged:
+		return QCoreApplication::translate("DumpDiff", "Tech level");
+	}
+	return QString();
+}
+
+void DumpDiff::clear()
+{
+	_changes.clear();
+	_addedItems.clear();
+	_movedItems.clear();
+	_changedPlanets.clear();
+	_changedGoods.clear();
+}
+
+void DumpDiff::compare(const DumpSnapshot &before, const DumpSnapshot &after)
+{
+	clear();
+	using Item = DumpSnapshot::Item;
+	using Market = DumpSnapshot::Market;
+	using Planet = DumpSnapshot::Planet;
+
+	join(before.items, after.items, [](const Item &i) { return i.id; },
+	     [this](const Item &b, const Item &a) {
+		     if (b.locationType != a.locationType
+			 || b.locationId != a.locationId) {
+			     _changes.push_back({kItemMoved, a.id, -1, a.name,
+						 b.location, a.location});
+			     _movedItems.insert(a.id);
+		     }
+	     },
+	     [this](const Item &b) {
+		     _changes.push_back({kItemRemoved, b.id, -1, b.name,
+					 b.location, QString()});
+	     },
+	     [this](const Item &a) {
+		     _changes.push_back({kItemAdded, a.id, -1, a.name,
+					 QString(), a.location});
+		     _addedItems.insert(a.id);
+	     });
+
+	// markets that come or go are ships, their items tell about them
+	join(before.markets, after.markets, [](const Market &m) { return m.key; },
+	     [this](const Market &b, const Market &a) { compareMarkets(b, a); },
+	     [](const Market &) {}, [](const Market &) {});
+
+	join(before.planets, after.planets, [](const Planet &p) { return p.id; },
+	     [this](const Planet &b, const Planet &a) {
+		     if (b.owner != a.owner) {
+			     _changes.push_back({kOwnerChanged, a.id, -1, a.name,
+						 b.owner, a.owner});
+			     _changedPlanets.insert(a.id);
+		     }
+		     if (b.techLevel != a.techLevel) {
+			     _changes.push_back({kTechLevelChanged, a.id, -1,
+						 a.name,
+						 QString::number(b.techLevel),
+						 QString::number(a.techLevel)});
+			     _changedPlanets.insert(a.id);
+		     }
+	     },
+	     [](const Planet &) {}, [](const Planet &) {});
+}
+
+void DumpDiff::compareMarkets(const DumpSnapshot::Market &before,
+			      const DumpSnapshot::Market &after)
+{
+	for (int good = 0; good < 8; good++) {
+		if (before.sale[good] == after.sale[good]
+		    && before.buy[good] == after.buy[good]) {
+			continue;
+		}
+		_changes.push_back({kPriceChanged, unsigned(after.key), good,
+				    after.name,
+				    prices(before.sale, before.buy, good),
+				    prices(after.sale, after.buy, good)});
+		_changedGoods[after.key] |= 1 << good;
+	}
+}
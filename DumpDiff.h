@@ -0,0 +1,122 @@
+#ifndef DUMPDIFF_H
+#define DUMPDIFF_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <vector>
+
+#include "GoodsArr.h"
+
+class Galaxy;
+
+//What DumpDiff compares of one dump, in flat arrays sorted by id. Small
+//enough to keep the previous dump around instead of its Galaxy.
+struct DumpSnapshot
+{
+	struct Item
+	{
+		unsigned id;
+		int locationType;
+		unsigned locationId;
+		QString name;
+		QString location;//name of the ship, planet or star
+	};
+	struct Market
+	{
+		quint64 key;//see DumpDiff::marketKey()
+		QString name;
+		GoodsArr sale;
+		GoodsArr buy;
+	};
+	struct Planet
+	{
+		unsigned id;
+		QString name;
+		QString owner;
+		unsigned techLevel;
+	};
+
+	DumpSnapshot() {}
+	explicit DumpSnapshot(const Galaxy& galaxy);
+	bool isEmpty() const
+	{
+		return stars.empty();
+	}
+	//the stars of a game don't change between its dumps
+	bool sameGame(const DumpSnapshot& other) const
+	{
+		return stars==other.stars;
+	}
+
+	std::vector<unsigned> stars;
+	std::vector<Item> items;
+	std::vector<Market> markets;
+	std::vector<Planet> planets;
+};
+
+//Changes between two dumps of one game: items that appeared, disappeared or
+//were moved, prices of the markets and owners and tech levels of the
+//planets. The snapshots are joined by id in one pass over each pair of
+//arrays. The models look up their rows in the sets to highlight them.
+class DumpDiff
+{
+public:
+	enum Kind {kItemAdded, kItemRemoved, kItemMoved, kPriceChanged,
+		   kOwnerChanged, kTechLevelChanged};
+	struct Change
+	{
+		Kind kind;
+		unsigned id;//of the item, market or planet
+		int good;//of a price, -1 otherwise
+		QString name;
+		QString before;
+		QString after;
+	};
+
+	//planets and ships are markets, their ids may be the same
+	static quint64 marketKey(bool ship, unsigned id)
+	{
+		return (quint64(ship)<<32) | id;
+	}
+	static quint64 marketKey(const Galaxy& galaxy, unsigned row);
+	static QString kindName(Kind kind);
+
+	void clear();
+	void compare(const DumpSnapshot& before, const DumpSnapshot& after);
+	const std::vector<Change>& changes() const
+	{
+		return _changes;
+	}
+	bool isEmpty() const
+	{
+		return _changes.empty();
+	}
+	bool itemAdded(unsigned id) const
+	{
+		return _addedItems.contains(id);
+	}
+	bool itemMoved(unsigned id) const
+	{
+		return _movedItems.contains(id);
+	}
+	bool planetChanged(unsigned id) const
+	{
+		return _changedPlanets.contains(id);
+	}
+	bool priceChanged(quint64 marketKey, int good) const
+	{
+		return _changedGoods.value(marketKey) & (1<<good);
+	}
+
+private:
+	void compareMarkets(const DumpSnapshot::Market& before, const DumpSnapshot::Market& after);
+
+	std::vector<Change> _changes;
+	QSet<unsigned> _addedItems;
+	QSet<unsigned> _movedItems;
+	QSet<unsigned> _changedPlanets;
+	QHash<quint64,int> _changedGoods;//market key -> bit per good
+};
+
+#endif // DUMPDIFF_H
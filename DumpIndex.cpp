@@ -0,0 +1,373 @@
+#include "DumpIndex.h"
+#include "EquipmentTableModel.h"
+#include "Galaxy.h"
+#include "RowFilter.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+
+namespace
+{
+const quint32 kMagic = 0x53524458; // SRDX
+const quint32 kFormat = 1;
+const char kIndexName[] = "dumps.sridx";
+// the text columns of the equipment table with a few dozen values
+const int kValueColumns[] = {2, 4, 7, 11};
+const int kNameColumn = 1;
+const int kDistanceColumn = 10;
+
+QString term(int col, const QString &value)
+{
+	return QString::number(col) + ':' + value;
+}
+
+QString depthTerm(int bucket)
+{
+	return "depth:" + QString::number(bucket);
+}
+
+// FNV-1a, stable between runs unlike qHash
+quint32 hash(const QStringRef &text, quint32 seed)
+{
+	quint32 h = 2166136261u ^ seed;
+	for (QChar c : text) {
+		h = (h ^ c.unicode()) * 16777619u;
+	}
+	return h;
+}
+
+std::vector<int> unite(const std::vector<int> &a, const std::vector<int> &b)
+{
+	std::vector<int> result;
+	std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+		       std::back_inserter(result));
+	return result;
+}
+
+std::vector<int> intersect(const std::vector<int> &a,
+			   const std::vector<int> &b)
+{
+	std::vector<int> result;
+	std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+			      std::back_inserter(result));
+	return result;
+}
+} // namespace
+
+void DumpIndex::addTrigrams(Bloom &bloom, const QString &text)
+{
+	for (int i = 0; i + 3 <= text.size(); i++) {
+		const QStringRef trigram = text.midRef(i, 3);
+		for (quint32 seed = 0; seed < 3; seed++) {
+			const quint32 bit = hash(trigram, seed) % (kBloomWords * 64);
+			bloom[bit / 64] |= quint64(1) << (bit % 64);
+		}
+	}
+}
+
+bool DumpIndex::hasTrigrams(const Bloom &bloom, const QString &text)
+{
+	for (int i = 0; i + 3 <= text.size(); i++) {
+		const QStringRef trigram = text.midRef(i, 3);
+		for (quint32 seed = 0; seed < 3; seed++) {
+			const quint32 bit = hash(trigram, seed) % (kBloomWords * 64);
+			if (!(bloom[bit / 64] & (quint64(1) << (bit % 64)))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+DumpIndex::Terms DumpIndex::terms(const Galaxy &galaxy)
+{
+	Terms terms;
+	terms.names.fill(0);
+	EquipmentTableModel model(&galaxy);
+	QSet<QString> set;
+	for (int row = 0; row < model.rowCount(); row++) {
+		for (int col : kValueColumns) {
+			set.insert(term(col, model.index(row, col).data().toString()));
+		}
+		// tranclucator items are infinitely far and have no bucket, a
+		// Dist. cap never takes them
+		const double distance =
+			model.index(row, kDistanceColumn).data().toDouble();
+		if (std::isfinite(distance)) {
+			set.insert(term(kDistanceColumn,
+					QString::number(int(distance)
+							/ kDistanceStep)));
+		}
+		const int depth = galaxy.equipmentDepth(row);
+		if (depth >= 0) {
+			set.insert(depthTerm(depth / kDepthStep));
+		}
+		addTrigrams(terms.names,
+			    model.index(row, kNameColumn).data().toString().toLower());
+	}
+	terms.terms = set.toList();
+	return terms;
+}
+
+bool DumpIndex::load(const QString &dir)
+{
+	_fileName = QDir(dir).filePath(kIndexName);
+	_dumps.clear();
+	_postings.clear();
+	QFile file(_fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+	const QByteArray data = qUncompress(file.readAll());
+	QDataStream stream(data);
+	stream.setVersion(QDataStream::Qt_5_0);
+	quint32 magic, format, dumps, terms;
+	stream >> magic >> format;
+	if (magic != kMagic || format != kFormat) {
+		return false;
+	}
+	stream >> dumps;
+	for (quint32 i = 0; i < dumps && stream.status() == QDataStream::Ok;
+	     i++) {
+		Dump dump;
+		stream >> dump.fileName >> dump.modified;
+		dump.fileName = QDir(dir).filePath(dump.fileName);
+		for (quint64 &word : dump.names) {
+			stream >> word;
+		}
+		_dumps.push_back(dump);
+	}
+	// the posting lists are stored as gaps
+	stream >> terms;
+	for (quint32 i = 0; i < terms && stream.status() == QDataStream::Ok;
+	     i++) {
+		QString term;
+		quint32 size;
+		stream >> term >> size;
+		std::vector<int> &list = _postings[term];
+		quint32 dump = 0;
+		for (quint32 j = 0; j < size && stream.status() == QDataStream::Ok;
+		     j++) {
+			quint32 gap;
+			stream >> gap;
+			dump += gap;
+			list.push_back(dump);
+		}
+	}
+	if (stream.status() != QDataStream::Ok) {
+		_dumps.clear();
+		_postings.clear();
+		return false;
+	}
+	return true;
+}
+
+bool DumpIndex::save() const
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << kMagic << kFormat << quint32(_dumps.size());
+	for (const Dump &dump : _dumps) {
+		stream << QFileInfo(dump.fileName).fileName() << dump.modified;
+		for (quint64 word : dump.names) {
+			stream << word;
+		}
+	}
+	stream << quint32(_postings.size());
+	for (auto i = _postings.begin(); i != _postings.end(); ++i) {
+		stream << i.key() << quint32(i.value().size());
+		int previous = 0;
+		for (int dump : i.value()) {
+			stream << quint32(dump - previous);
+			previous = dump;
+		}
+	}
+	QFile file(_fileName);
+	return file.open(QIODevice::WriteOnly)
+	       && file.write(qCompress(data)) >= 0;
+}
+
+int DumpIndex::update(const QStringList &fileNames)
+{
+	// the dumps that are still there and unchanged keep their terms
+	const QSet<QString> present = fileNames.toSet();
+	std::vector<int> renumber(_dumps.size(), -1);
+	std::vector<Dump> kept;
+	QSet<QString> indexed;
+	for (unsigned i = 0; i < _dumps.size(); i++) {
+		const Dump &dump = _dumps[i];
+		if (present.contains(dump.fileName)
+		    && QFileInfo(dump.fileName).lastModified() == dump.modified) {
+			renumber[i] = kept.size();
+			kept.push_back(dump);
+			indexed.insert(dump.fileName);
+		}
+	}
+	if (kept.size() < _dumps.size()) {
+		for (auto i = _postings.begin(); i != _postings.end();) {
+			std::vector<int> list;
+			for (int dump : i.value()) {
+				if (renumber[dump] >= 0) {
+					list.push_back(renumber[dump]);
+				}
+			}
+			if (list.empty()) {
+				i = _postings.erase(i);
+			} else {
+				i.value().swap(list);
+				++i;
+			}
+		}
+	}
+	_dumps.swap(kept);
+
+	QVector<QString> todo;
+	for (const QString &fileName : fileNames) {
+		if (!indexed.contains(fileName)) {
+			todo << fileName;
+		}
+	}
+	struct Indexed
+	{
+		bool ok = false;
+		QDateTime modified;
+		Terms terms;
+	};
+	const QVector<Indexed> results =
+		QtConcurrent::blockingMapped<QVector<Indexed>>(
+			todo, [](const QString &fileName) {
+				Indexed indexed;
+				indexed.modified = QFileInfo(fileName).lastModified();
+				QString buf;
+				if (!readDumpFile(fileName, buf)) {
+					return indexed;
+				}
+				Galaxy galaxy;
+				ParseProjection projection;
+				projection.fields = ParseProjection::kEquipmentNames;
+				galaxy.setProjection(projection);
+				QTextStream stream(&buf);
+				try {
+					galaxy.parseDump(stream);
+					buf.clear();
+					indexed.terms = terms(galaxy);
+					indexed.ok = true;
+				} catch (const std::exception &) {
+					// not a dump, tried again next time
+				}
+				return indexed;
+			});
+	int added = 0;
+	for (int i = 0; i < todo.size(); i++) {
+		if (!results[i].ok) {
+			continue;
+		}
+		const int dump = _dumps.size();
+		_dumps.push_back({todo[i], results[i].modified,
+				  results[i].terms.names});
+		for (const QString &term : results[i].terms.terms) {
+			_postings[term].push_back(dump);
+		}
+		added++;
+	}
+	return added;
+}
+
+std::vector<int> DumpIndex::postings(const QStringList &terms) const
+{
+	std::vector<int> result;
+	for (const QString &term : terms) {
+		auto list = _postings.find(term);
+		if (list != _postings.end()) {
+			result = unite(result, list.value());
+		}
+	}
+	return result;
+}
+
+std::vector<int> DumpIndex::candidates(const RowFilter &filter,
+				       int maxDepth) const
+{
+	std::vector<int> result(_dumps.size());
+	std::iota(result.begin(), result.end(), 0);
+	// the values of a column are few, the filter is run over them
+	for (int col : kValueColumns) {
+		const QRegularExpression *re = filter.match(col);
+		if (!re) {
+			continue;
+		}
+		const QString prefix = term(col, QString());
+		QStringList terms;
+		for (auto i = _postings.begin(); i != _postings.end(); ++i) {
+			if (i.key().startsWith(prefix)
+			    && i.key().mid(prefix.size()).contains(*re)) {
+				terms << i.key();
+			}
+		}
+		result = intersect(result, postings(terms));
+	}
+	double maxDistance;
+	if (filter.max(kDistanceColumn, maxDistance)) {
+		QStringList terms;
+		for (int bucket = 0; bucket <= maxDistance / kDistanceStep;
+		     bucket++) {
+			terms << term(kDistanceColumn, QString::number(bucket));
+		}
+		result = intersect(result, postings(terms));
+	}
+	if (maxDepth >= 0) {
+		QStringList terms;
+		for (int bucket = 0; bucket <= maxDepth / kDepthStep; bucket++) {
+			terms << depthTerm(bucket);
+		}
+		result = intersect(result, postings(terms));
+	}
+	QStringList names;
+	const QRegularExpression *nameRe = filter.match(kNameColumn);
+	if (nameRe && RowFilter::literals(*nameRe, names)) {
+		std::vector<int> named;
+		for (int dump : result) {
+			for (const QString &name : names) {
+				if (hasTrigrams(_dumps[dump].names, name.toLower())) {
+					named.push_back(dump);
+					break;
+				}
+			}
+		}
+		result.swap(named);
+	}
+	return result;
+}
+
+int DumpIndex::matches(const QString &fileName, const RowFilter &filter,
+		       int maxDepth)
+{
+	QString buf;
+	if (!readDumpFile(fileName, buf)) {
+		return 0;
+	}
+	Galaxy galaxy;
+	QTextStream stream(&buf);
+	galaxy.parseDump(stream);
+	buf.clear();
+	EquipmentTableModel model(&galaxy);
+	int count = 0;
+	for (int row = 0; row < model.rowCount(); row++) {
+		const int depth = galaxy.equipmentDepth(row);
+		if ((maxDepth < 0 || (depth >= 0 && depth <= maxDepth))
+		    && filter.accepts(model, row)) {
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,73 @@
+#ifndef DUMPINDEX_H
+#define DUMPINDEX_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <vector>
+
+class Galaxy;
+class RowFilter;
+
+//What the items of every dump of a folder are, so that an equipment filter
+//can be run over thousands of kept dumps without parsing them all. Posting
+//lists map the values of the Type, Made, Location type and Owner columns,
+//the quantized Dist. from the player and the depth of buried items to the
+//dumps having them; a Bloom filter per dump holds the trigrams of the item
+//names. The terms are per dump, not per item, so the candidates are a
+//superset of the matching dumps and are checked by a full parse.
+class DumpIndex
+{
+public:
+	static const int kDistanceStep=15;
+	static const int kDepthStep=100;
+
+	//reads the index of dir, empty if it has none
+	bool load(const QString& dir);
+	bool save() const;
+	//indexes the new and changed dumps of the folder in parallel and drops
+	//the ones that are gone; returns the number of dumps indexed
+	int update(const QStringList& fileNames);
+	int count() const
+	{
+		return _dumps.size();
+	}
+	QString fileName(int dump) const
+	{
+		return _dumps[dump].fileName;
+	}
+
+	//dumps that may have an item accepted by the filter of the equipment
+	//table and buried at most maxDepth deep, -1 for any item
+	std::vector<int> candidates(const RowFilter& filter, int maxDepth=-1) const;
+	//parses the dump and counts the items the candidate really has
+	static int matches(const QString& fileName, const RowFilter& filter, int maxDepth=-1);
+
+private:
+	static const int kBloomWords=64;
+	using Bloom=std::array<quint64,kBloomWords>;
+	struct Dump
+	{
+		QString fileName;
+		QDateTime modified;
+		Bloom names;
+	};
+	struct Terms
+	{
+		QStringList terms;
+		Bloom names;
+	};
+	static Terms terms(const Galaxy& galaxy);
+	static void addTrigrams(Bloom& bloom, const QString& text);
+	static bool hasTrigrams(const Bloom& bloom, const QString& text);
+	//dumps with one of the terms, sorted
+	std::vector<int> postings(const QStringList& terms) const;
+
+	QString _fileName;
+	std::vector<Dump> _dumps;
+	QHash<QString,std::vector<int>> _postings;//term -> sorted dumps
+};
+
+#endif // DUMPINDEX_H
@@ -51,6 +51,9 @@ Equipment::Equipment(QTextStream &stream, Galaxy &galaxy, LocationType locationT
 		switch(eqOptions.value(varname,-1))
 		{
 		case 0://IName
+			if(!galaxy.projection().has(ParseProjection::kEquipmentNames)) {
+				break;
+			}
 			_name=std::move(value.remove("</color>"));
 			_name.remove('"');
 			_name.remove(QRegularExpression("<color=([0-9]*,*)*>"));
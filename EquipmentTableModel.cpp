@@ -1,10 +1,9 @@
 #include "EquipmentTableModel.h"
 #include "Galaxy.h"
-#include "FilterHorizontalHeaderView.h"
-#include <QLineEdit>
-#include <QSpinBox>
-#include <QVBoxLayout>
-#include <QComboBox>
+#include "DumpDiff.h"
+#include "SortMultiFilterProxyModel.h"
+#include <QBrush>
+#include <algorithm>
 
 EquipmentTableModel::EquipmentTableModel(const Galaxy *galaxy, QObject *parent) :
 	QAbstractTableModel(parent),_galaxy(galaxy)
@@ -22,14 +21,29 @@ int EquipmentTableModel::rowCount(const QModelIndex &parent) const
 
 int EquipmentTableModel::columnCount(const QModelIndex &parent) const
 {
-	return 14;
+	return 15;
 }
 
 QVariant EquipmentTableModel::data(const QModelIndex &index, int role) const
 {
 	if (role == Qt::BackgroundRole) {
+		if (!colors.contains(index.row()) && _diff) {
+			const unsigned id=_galaxy->equipmentId(index.row());
+			if (_diff->itemAdded(id)) {
+				return QBrush(QColor(200,255,200));
+			}
+			if (_diff->itemMoved(id)) {
+				return QBrush(QColor(255,240,170));
+			}
+		}
 		return QBrush(colors.value(index.row(),QColor("white")));
 	}
+	if (role == RowFilter::StarIdRole) {
+		return _galaxy->equipmentStarId(index.row());
+	}
+	if (role == RowFilter::DepthRole) {
+		return std::max(0,_galaxy->equipmentDepth(index.row()));
+	}
 	int col=index.column();
 	if (role == Qt::EditRole) {
 		if (col==0) {
@@ -88,8 +102,8 @@ QVariant EquipmentTableModel::data(const QModelIndex &index, int role) const
 			return _galaxy->equipmentStarName(index.row());
 			break;
 
-		case 10://Distance to star from Player
-			return std::round(_galaxy->equipmentDistFromPlayer(index.row()));
+		case kDistColumn://Distance to star from the reference star
+			return std::round(_galaxy->equipmentDistance(index.row(),_galaxy->referenceStarId(_referenceStar)));
 			break;
 
 		case 11://Star Owner
@@ -104,10 +118,17 @@ QVariant EquipmentTableModel::data(const QModelIndex &index, int role) const
 			return _galaxy->equipmentBonus(index.row());
 			break;
 
+		case kRouteColumn://Travelled to the star, black holes included
+			return std::round(_galaxy->routeDistance(_galaxy->referenceStarId(_referenceStar),_galaxy->equipmentStarId(index.row())));
+			break;
+
 		}
 
 		return "asd";
 	}
+	if (role==Qt::ToolTipRole && index.column()==kRouteColumn) {
+		return _galaxy->routeText(_galaxy->referenceStarId(_referenceStar),_galaxy->equipmentStarId(index.row()));
+	}
 	if (role==Qt::ToolTipRole) {
 		QString str=data(index,Qt::DisplayRole).toString();
 		if(! str.isEmpty()) {
@@ -121,7 +142,8 @@ QVariant EquipmentTableModel::headerData(int section, Qt::Orientation orientatio
 {
 	static const QVector<QString> header={tr("Color"),tr("Name"),tr("Type"),tr("Size"),tr("Made"),
 					      tr("Cost"),tr("TL"), tr("Location type"),
-					      tr("Location"),tr("Star"),tr("Dist."), tr("Owner"), tr("Durab."),tr("Bonus")};
+					      tr("Location"),tr("Star"),tr("Dist."), tr("Owner"), tr("Durab."),tr("Bonus"),
+					      tr("Route")};
 	if (role == Qt::DisplayRole)
 	{
 		if (orientation == Qt::Vertical)
@@ -138,16 +160,17 @@ QVariant EquipmentTableModel::headerData(int section, Qt::Orientation orientatio
 			switch (section)
 			{
 			case 0:
-				return FilterHorizontalHeaderView::wtNone;
+				return SortMultiFilterProxyModel::ctNone;
 			case 3:
 			case 5:
 			case 6:
-			case 10:
-				return FilterHorizontalHeaderView::wtInt;
+			case kDistColumn:
+			case kRouteColumn:
+				return SortMultiFilterProxyModel::ctInt;
 			case 12:
-				return FilterHorizontalHeaderView::wtDouble;
+				return SortMultiFilterProxyModel::ctDouble;
 			default:
-				return FilterHorizontalHeaderView::wtString;
+				return SortMultiFilterProxyModel::ctString;
 			}
 		}
 	}
@@ -7,6 +7,7 @@
 #include <iostream>
 
 class Galaxy;
+class DumpDiff;
 
 bool operator<(const QColor & a, const QColor & b);
 
@@ -14,6 +15,8 @@ class EquipmentTableModel : public QAbstractTableModel
 {
     Q_OBJECT
 public:
+    //columns measured from the reference star, also read by the presets
+    enum {kDistColumn=10, kRouteColumn=14};
     explicit EquipmentTableModel(const Galaxy* galaxy, QObject *parent = 0);
     int rowCount(const QModelIndex &parent = QModelIndex()) const ;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
@@ -22,6 +25,20 @@ public:
     Qt::ItemFlags flags(const QModelIndex &index) const;
     bool setData(const QModelIndex &index, const QVariant &value,
 		     int role = Qt::EditRole);
+    //Dist. and Route of the items from this star, -1 for the star of the player
+    void setReferenceStar(int starId)
+    {
+	_referenceStar=starId;
+	if(rowCount()>0) {
+	    emit dataChanged(index(0,kDistColumn),index(rowCount()-1,kDistColumn));
+	    emit dataChanged(index(0,kRouteColumn),index(rowCount()-1,kRouteColumn));
+	}
+    }
+    //added and moved items are highlighted unless they have a colour
+    void setDiff(const DumpDiff* diff)
+    {
+	_diff=diff;
+    }
     void reload()
     {
 	beginResetModel();
@@ -39,6 +56,8 @@ public slots:
 
 private:
     const Galaxy *_galaxy;
+    int _referenceStar=-1;
+    const DumpDiff* _diff=nullptr;
     QMap<int,QColor> colors;
     QMap<QRgb,QString> colorNames;
 };
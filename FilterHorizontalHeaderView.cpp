@@ -5,6 +5,7 @@
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QCoreApplication>
+#include <cmath>
 
 FilterHorizontalHeaderView::FilterHorizontalHeaderView(SortMultiFilterProxyModel *model, QTableView *parent):
 	QHeaderView(Qt::Horizontal,parent)
@@ -38,6 +39,11 @@ FilterHorizontalHeaderView::FilterHorizontalHeaderView(SortMultiFilterProxyModel
 		insertColumns(logicalFirst,logicalLast);
 	});
 
+	//the tooltips of the spinboxes show the range of their column
+	connect(model,&QAbstractItemModel::modelReset,this,&FilterHorizontalHeaderView::updateRanges);
+	connect(model,&QAbstractItemModel::rowsInserted,this,&FilterHorizontalHeaderView::updateRanges);
+	updateRanges();
+
 	timer.setInterval(300);
 	timer.setSingleShot(true);
 	connect(&timer,SIGNAL(timeout()),this,SLOT(applyFilters()));
@@ -99,6 +105,7 @@ void FilterHorizontalHeaderView::setPreset(const QVariantMap &p)
 	}
 
 	setSortIndicator(p["sortColumn"].toInt(),(Qt::SortOrder)p["sortOrder"].toInt());
+	_model->setLimit(p.value("limit",0).toInt());
 	applyFilters();
 	_model->sort(p["sortColumn"].toInt(),(Qt::SortOrder)p["sortOrder"].toInt());
 }
@@ -294,6 +301,30 @@ void FilterHorizontalHeaderView::applyFilters()
 		}
 	}
 	_model->setFilters(match,notMatch,min,max);
+	//the columns with a bound have their range now
+	updateRanges();
+}
+
+void FilterHorizontalHeaderView::updateRanges()
+{
+	// only shown, a maximum would clamp the values of presets for other dumps;
+	// the columns without a bound have no range, it is not worth a pass over
+	// the table, let alone planning every route
+	auto showRange = [this](int col, QWidget* minEdit, QWidget* maxEdit) {
+		double min, max;
+		QString range;
+		if(_model->columnRange(col,min,max) && std::isfinite(min) && std::isfinite(max)) {
+			range=tr(", %1 to %2 in the table").arg(min).arg(max);
+		}
+		minEdit->setToolTip(tr("minimum value")+range);
+		maxEdit->setToolTip(tr("maximum value")+range);
+	};
+	for (auto i = minIntEdits.begin(); i != minIntEdits.end(); ++i) {
+		showRange(i.key(),i.value(),maxIntEdits[i.key()]);
+	}
+	for (auto i = minDoubleEdits.begin(); i != minDoubleEdits.end(); ++i) {
+		showRange(i.key(),i.value(),maxDoubleEdits[i.key()]);
+	}
 }
 
 QVariantMap FilterHorizontalHeaderView::preset() const
@@ -345,6 +376,9 @@ QVariantMap FilterHorizontalHeaderView::preset() const
 	}
 	allFilters.insert("maxDouble",std::move(maxDoubles));
 
+	if(_model->limit()>0) {
+		allFilters.insert("limit",_model->limit());
+	}
 	allFilters.insert("sortColumn",_model->sortColumn());
 	allFilters.insert("sortOrder",_model->sortOrder());
 
@@ -26,7 +26,10 @@ class FilterHorizontalHeaderView : public QHeaderView
 {
 	Q_OBJECT
 public:
-	enum WidgetType {wtString, wtInt, wtDouble, wtNone};
+	enum WidgetType {wtString=SortMultiFilterProxyModel::ctString,
+			 wtInt=SortMultiFilterProxyModel::ctInt,
+			 wtDouble=SortMultiFilterProxyModel::ctDouble,
+			 wtNone=SortMultiFilterProxyModel::ctNone};
 	explicit FilterHorizontalHeaderView(SortMultiFilterProxyModel* model, QTableView *parent = 0);
 	QSize sizeHint() const;
 	void addPreset(const QVariantMap& p, const QString& name)
@@ -58,6 +61,7 @@ private slots:
 	void activatePreset(int i);
 	void clearAllFilters();
 	void applyFilters();
+	void updateRanges();
 
 private:
 	void updateGeometry(int logical) const;
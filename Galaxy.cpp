@@ -1,9 +1,11 @@
 #include "Galaxy.h"
-#include <QStaticText>
+#include "GalaxyMapRenderer.h"
+#include "HashAggregate.h"
 #include <QFile>
 #include <QJsonDocument>
 #include <QDate>
 #include <QGuiApplication>
+#include <QTextCodec>
 #include <set>
 
 
@@ -56,6 +58,9 @@ Galaxy::Galaxy()
 void Galaxy::parseDump(QTextStream &stream)
 {
 	clear();
+	if (_parseObserver) {
+		_parseObserver->parseStarted(*this);
+	}
 	const static QMap<QString, int> globalOptions = {
 		{"Player ^{", 0}, {"StarList ^{", 1}, {"HoleList ^{", 2}};
 
@@ -80,14 +85,20 @@ void Galaxy::parseDump(QTextStream &stream)
 
 		default:
 			if (line.startsWith("IDay=")) {
-				currentDay = line.mid(5).toInt();
-				std::cout << "currentDay=" << currentDay
+				_currentDay = line.mid(5).toInt();
+				std::cerr << "currentDay=" << _currentDay
 					  << std::endl;
 			}
 			// skip record
 			break;
 		}
 	} while (!line.isNull());
+	_starIndex.build();
+	_routePlanner.build(_starIndex, blackHoles);
+	_marketMatrix.build(*this);
+	if (_parseObserver) {
+		_parseObserver->parseFinished(*this);
+	}
 }
 
 void Galaxy::clear()
@@ -101,6 +112,10 @@ void Galaxy::clear()
 	shipMarkets.clear();
 	eqVec.clear();
 	planetVec.clear();
+	_starIndex.clear();
+	_routePlanner.clear();
+	_marketMatrix.clear();
+	_currentDay = 0;
 	_minSellPrice.set(std::numeric_limits<unsigned>::max());
 	_maxBuyPrice.set(0);
 }
@@ -187,7 +202,11 @@ void Galaxy::addStar(const Star &&star)
 				  // already existing. This should not happen!"
 	galaxyMapRect |=
 		QRectF(star.position().x(), star.position().y(), 1.0, 1.0);
+	_starIndex.add(star.id(), star.position());
 	starMap.insert(std::move(std::make_pair(star.id(), std::move(star))));
+	if (_parseObserver) {
+		_parseObserver->starParsed(*this);
+	}
 }
 
 void Galaxy::addBlackHole(const BlackHole &&bh)
@@ -333,15 +352,9 @@ unsigned Galaxy::marketId(unsigned row) const
 	return -1; // should never reach hear
 }
 
-double Galaxy::marketDistFromPlayer(unsigned row) const
+double Galaxy::marketDistance(unsigned row, unsigned fromStarId) const
 {
-	assert(shipMap.count(0));
-	unsigned mStarId = marketStarId(row);
-	unsigned playerStarId = shipMap.at(0).starId();
-	QPointF playerPos = starMap.at(playerStarId).position();
-	QPointF marketPos = starMap.at(mStarId).position();
-	QPointF delta = playerPos - marketPos;
-	return sqrt(pow(delta.x(), 2) + pow(delta.y(), 2));
+	return starDistance(fromStarId, marketStarId(row));
 }
 
 QString Galaxy::marketStarName(unsigned row) const
@@ -420,6 +433,41 @@ int Galaxy::equipmentDepth(unsigned row) const
 	return -1;
 }
 
+bool Galaxy::equipmentResolved(unsigned row) const
+{
+	if (!playerStarResolved()) {
+		return false;
+	}
+	const Equipment &eq = eqMap.at(eqVec.at(row));
+	unsigned locId = eq.locationId();
+	unsigned starId = 0;
+	switch (eq.locationType()) {
+	case Equipment::kShipEq:
+	case Equipment::kShipStorage:
+	case Equipment::kShipShop: {
+		auto ship = shipMap.find(locId);
+		if (ship == shipMap.end()) {
+			return false;
+		}
+		starId = ship->second.starId();
+	} break;
+	case Equipment::kJunk:
+		starId = locId;
+		break;
+	case Equipment::kPlanetShop:
+	case Equipment::kPlanetStorage:
+	case Equipment::kPlanetTreasure: {
+		auto planet = planetMap.find(locId);
+		if (planet == planetMap.end()) {
+			return false;
+		}
+		starId = planet->second.starId();
+	} break;
+	}
+	// 0 is the Tranclucator
+	return starId == 0 || starMap.count(starId);
+}
+
 QString Galaxy::equipmentStarName(unsigned row) const
 {
 	int starId = equipmentStarId(row);
@@ -458,18 +506,14 @@ QString Galaxy::equipmentStarName(unsigned row) const
     return "...";*/
 }
 
-double Galaxy::equipmentDistFromPlayer(unsigned row) const
+double Galaxy::equipmentDistance(unsigned row, unsigned fromStarId) const
 {
 	unsigned eqStarId = equipmentStarId(row);
 	if (!eqStarId) {
 		// return std::numeric_limits<double>::quiet_NaN();
 		return std::numeric_limits<double>::infinity();
 	}
-	unsigned playerStarId = shipMap.at(0).starId();
-	QPointF playerPos = starMap.at(playerStarId).position();
-	QPointF eqPos = starMap.at(eqStarId).position();
-	QPointF delta = playerPos - eqPos;
-	return sqrt(pow(delta.x(), 2) + pow(delta.y(), 2));
+	return starDistance(fromStarId, eqStarId);
 }
 
 QString Galaxy::equipmentStarOwner(unsigned row) const
@@ -499,14 +543,9 @@ QString Galaxy::blackHoleStar1(unsigned row) const
 	return starMap.at(starId).name();
 }
 
-float Galaxy::blackHoleStar1Distance(unsigned row) const
+float Galaxy::blackHoleStar1Distance(unsigned row, unsigned fromStarId) const
 {
-	unsigned bhStarId = blackHoles[row].star1Id();
-	unsigned playerStarId = shipMap.at(0).starId();
-	QPointF playerPos = starMap.at(playerStarId).position();
-	QPointF eqPos = starMap.at(bhStarId).position();
-	QPointF delta = playerPos - eqPos;
-	return sqrt(pow(delta.x(), 2) + pow(delta.y(), 2));
+	return starDistance(fromStarId, blackHoles[row].star1Id());
 }
 
 QString Galaxy::blackHoleStar2(unsigned row) const
@@ -515,14 +554,9 @@ QString Galaxy::blackHoleStar2(unsigned row) const
 	return starMap.at(starId).name();
 }
 
-float Galaxy::blackHoleStar2Distance(unsigned row) const
+float Galaxy::blackHoleStar2Distance(unsigned row, unsigned fromStarId) const
 {
-	unsigned bhStarId = blackHoles[row].star2Id();
-	unsigned playerStarId = shipMap.at(0).starId();
-	QPointF playerPos = starMap.at(playerStarId).position();
-	QPointF eqPos = starMap.at(bhStarId).position();
-	QPointF delta = playerPos - eqPos;
-	return sqrt(pow(delta.x(), 2) + pow(delta.y(), 2));
+	return starDistance(fromStarId, blackHoles[row].star2Id());
 }
 
 int Galaxy::blackHoleTurnsToClose(unsigned row) const
@@ -532,12 +566,12 @@ int Galaxy::blackHoleTurnsToClose(unsigned row) const
 
 QString Galaxy::blackHoleNextLootChange(unsigned row) const
 {
-	QDate today = QDate(3300, 1, 1).addDays(currentDay - 301);
+	QDate today = QDate(3300, 1, 1).addDays(_currentDay - 301);
 	QString changes;
 	int ttclose = blackHoleTurnsToClose(row);
 	int lastChange = std::min(ttclose, 77 * 5);
 	lastChange = ttclose < 1 ? 77 * 5 : lastChange;
-	for (unsigned daysToChange = 77 - (currentDay % 77);
+	for (unsigned daysToChange = 77 - (_currentDay % 77);
 	     daysToChange < lastChange; daysToChange += 77) {
 		changes += today.addDays(daysToChange).toString("dd MMMM yyyy")
 			   + "; ";
@@ -548,15 +582,55 @@ QString Galaxy::blackHoleNextLootChange(unsigned row) const
 	return changes;
 }
 
+double Galaxy::routeDistance(unsigned fromStarId, unsigned starId) const
+{
+	if (!_starIndex.contains(starId)) {
+		return std::numeric_limits<double>::infinity();
+	}
+	if (!_routePlanner.isBuilt()) {
+		return starDistance(fromStarId, starId);
+	}
+	return _routePlanner.distance(fromStarId, starId);
+}
+
+std::vector<RoutePlanner::Hop> Galaxy::route(unsigned fromStarId,
+					     unsigned starId) const
+{
+	if (!_routePlanner.isBuilt() || !_starIndex.contains(starId)) {
+		return {};
+	}
+	return _routePlanner.route(fromStarId, starId);
+}
+
+QString Galaxy::routeText(unsigned fromStarId, unsigned starId) const
+{
+	QString text;
+	for (const RoutePlanner::Hop &hop : route(fromStarId, starId)) {
+		if (!text.isEmpty()) {
+			text += hop.blackHole ? " >> " : " > ";
+		}
+		text += starName(hop.starId);
+	}
+	return text;
+}
+
 struct NumShips {
 	int normals = 0;
 	int pirates = 0;
 	int kellers = 0;
 	int terrons = 0;
 	int blazers = 0;
-	const QString dummy = "<font color=%2>%1<color>/";
-	QString infoStr(const QMap<QString, QColor> &colMap)
+	void add(const NumShips &other)
+	{
+		normals += other.normals;
+		pirates += other.pirates;
+		kellers += other.kellers;
+		terrons += other.terrons;
+		blazers += other.blazers;
+	}
+	QString infoStr(const QMap<QString, QColor> &colMap) const
 	{
+		const QString dummy = "<font color=%2>%1<color>/";
 		QString str;
 		if (normals > 0)
 			str += dummy.arg(normals).arg(
@@ -579,37 +653,22 @@ struct NumShips {
 	}
 };
 
-QImage Galaxy::map(const unsigned width, const int fontSize) const
+std::vector<MapStar> Galaxy::mapStars() const
 {
-	// QImage
-	// image((mapRect.width()+8)*scale,(mapRect.height()+6)*scale,QImage::Format_ARGB32);
-	const unsigned padding = fontSize * 4;
-	const unsigned netWidth = width - 2.0 * padding;
-	const unsigned height =
-		2.0 * padding
-		+ netWidth * galaxyMapRect.height() / galaxyMapRect.width();
-	QImage image(width, height, QImage::Format_ARGB32);
-	image.fill(Qt::black);
-	QPainter p(&image);
-	p.setPen(QPen(QColor(Qt::white)));
-	p.setBrush(QBrush(QColor(Qt::white), Qt::SolidPattern));
-	p.setRenderHint(QPainter::Antialiasing, true);
-	QFont font("Arial");
-	//        font.setStretch(QFont::SemiCondensed);
-	font.setPointSize(fontSize);
-	p.setFont(font);
 	// prepare base names
-	QMap<unsigned, QString> starIdToBases;
-	for (unsigned baseId : shipMarkets) {
-		const Ship &ship = shipMap.at(baseId);
-		QString base = ship.name().left(2);
-		unsigned starId = ship.starId();
-		QString &basesStr = starIdToBases[starId];
-		if (basesStr.length()) {
-			basesStr += ',';
-		}
-		basesStr += base;
-	}
+	const QHash<unsigned, QString> starIdToBases =
+		hashAggregate<unsigned, QString>(
+			shipMarkets.size(),
+			[&](int row) { return shipMap.at(shipMarkets[row]).starId(); },
+			[&](QString &basesStr, int row) {
+				if (basesStr.length()) {
+					basesStr += ',';
+				}
+				basesStr += shipMap.at(shipMarkets[row]).name().left(2);
+			},
+			[](QString &basesStr, const QString &later) {
+				basesStr += ',' + later;
+			});
 	// prepare planets
 	QMap<unsigned, QString> starIdToPlanets;
 	const QString planetTemplate("<font color=%3>%1%2<color>");
@@ -631,93 +690,83 @@ QImage Galaxy::map(const unsigned width, const int fontSize) const
 		bhStarIds.insert(bh.star2Id());
 	}
 
-	std::map<unsigned, NumShips> starShips;
+	std::vector<const Ship *> ships;
+	ships.reserve(shipMap.size());
 	for (const auto &pair : shipMap) {
-		const Ship &ship = pair.second;
-		const unsigned starid = ship.starId();
-		const QString race = ship.race();
-		if (race == "Normal")
-			++starShips[starid].normals;
-		else if (race == "Pirate")
-			++starShips[starid].pirates;
-		else if (race == "Keller")
-			++starShips[starid].kellers;
-		else if (race == "Terron")
-			++starShips[starid].terrons;
-		else if (race == "Blazer")
-			++starShips[starid].blazers;
-		else
-			std::cerr << "ERROR! Unexpeced ship race: "
-					     + race.toStdString()
-				  << std::endl;
-	}
-
-	// Draw stars
-	const double scale = double(netWidth) / galaxyMapRect.width();
-	const double starR = 0.5 * fontSize;
-	const double starLineW = 0.5 * starR;
-
-	// QMap<unsigned,QPointF> starIdToPos;
+		ships.push_back(&pair.second);
+	}
+	const QHash<unsigned, NumShips> starShips =
+		hashAggregate<unsigned, NumShips>(
+			ships.size(),
+			[&](int row) { return ships[row]->starId(); },
+			[&](NumShips &numShips, int row) {
+				const QString race = ships[row]->race();
+				if (race == "Normal")
+					++numShips.normals;
+				else if (race == "Pirate")
+					++numShips.pirates;
+				else if (race == "Keller")
+					++numShips.kellers;
+				else if (race == "Terron")
+					++numShips.terrons;
+				else if (race == "Blazer")
+					++numShips.blazers;
+				else
+					std::cerr << "ERROR! Unexpeced ship race: "
+							     + race.toStdString()
+						  << std::endl;
+			},
+			[](NumShips &numShips, const NumShips &later) {
+				numShips.add(later);
+			});
+
+	std::vector<MapStar> stars;
+	stars.reserve(starMap.size());
 	for (const auto &pair : starMap) {
 		const Star &star = pair.second;
-		QPointF pos = star.position() - galaxyMapRect.topLeft();
-		pos *= scale;
-		pos += QPointF(padding, padding);
-		// starIdtoPos[star.id()]=pos;
 		QString owner = star.owner();
 		if (owner == "Klings") {
 			owner = star.domSeries();
 		}
-		p.setPen(Qt::white);
-		p.setBrush(
-			QBrush(QColor(_ownerToColor[owner]), Qt::SolidPattern));
-		QRectF nameRect;
-		nameRect.setTopLeft(pos + QPointF(-6 * fontSize, starR));
-		nameRect.setBottomRight(
-			pos + QPointF(fontSize * 6, fontSize * 2 + starR));
-		// p.drawRect(nameRect);
-		p.drawText(nameRect, star.name(),
-			   QTextOption(Qt::AlignHCenter | Qt::AlignTop));
-
-		const QString &basesStr = starIdToBases.value(star.id());
-		if (!basesStr.isEmpty()) {
-			QRectF basesRect =
-				QRectF(pos + QPointF(-8.0 * fontSize, -starR),
-				       pos + QPointF(-1.1 * starR, starR));
-			p.drawText(
-				basesRect, basesStr.left(2),
-				QTextOption(Qt::AlignRight | Qt::AlignVCenter));
-			if (basesStr.length() > 3) {
-				basesRect.translate(
-					8.0 * fontSize + 1.2 * starR, 0);
-				p.drawText(basesRect, basesStr.mid(3),
-					   QTextOption(Qt::AlignLeft
-						       | Qt::AlignVCenter));
-			}
-		}
-		p.setPen(
-			QPen(QBrush(_ownerToColor["line" + owner]), starLineW));
-		p.drawEllipse(pos, starR, starR);
-		QString shipsInfo = starShips[star.id()].infoStr(_ownerToColor);
-		QStaticText planetsText(shipsInfo
-					+ starIdToPlanets.value(star.id()));
-		planetsText.setTextFormat(Qt::RichText);
-		planetsText.prepare(QTransform(), font);
-		QPointF topLeft(pos);
-		topLeft.rx() -= 0.5 * planetsText.size().width();
-		topLeft.ry() -= 1.5 * fontSize + starR;
-		p.drawStaticText(topLeft, planetsText);
-
-		if (bhStarIds.count(star.id())) {
-			p.setBrush(
-				QBrush(QColor("darkblue"), Qt::SolidPattern));
-			p.setPen(QPen(QBrush(QColor("deepskyblue")),
-				      starR * 0.4));
-			p.drawEllipse(pos + QPointF(starR * 0.8, starR * 0.8),
-				      starR * 0.7, starR * 0.7);
-		}
+		MapStar mapStar;
+		mapStar.id = star.id();
+		mapStar.position = star.position();
+		mapStar.name = star.name();
+		mapStar.color = _ownerToColor.value(owner);
+		mapStar.lineColor = _ownerToColor.value("line" + owner);
+		mapStar.bases = starIdToBases.value(star.id());
+		mapStar.annotation = starShips.value(star.id()).infoStr(_ownerToColor)
+				     + starIdToPlanets.value(star.id());
+		mapStar.blackHole = bhStarIds.count(star.id());
+		stars.push_back(mapStar);
+	}
+	// stable drawing order, the star map is unordered
+	std::sort(stars.begin(), stars.end(),
+		  [](const MapStar &a, const MapStar &b) { return a.id < b.id; });
+	return stars;
+}
+
+QImage Galaxy::map(const unsigned width, const int fontSize) const
+{
+	GalaxyMapRenderer renderer;
+	renderer.setGalaxy(*this);
+	return renderer.render(width, fontSize);
+}
+
+bool readDumpFile(const QString &fileName, QString &buf)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return false;
+	}
+	QTextStream stream(&file);
+	buf = stream.read(500);
+	stream.seek(0);
+	if (buf.contains(QChar(65533))) {
+		stream.setCodec("Windows-1251");
 	}
-	return image;
+	buf = stream.readAll();
+	return true;
 }
 
 unsigned Galaxy::marketStarId(unsigned row) const
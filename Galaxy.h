@@ -5,6 +5,9 @@
 #include "Star.h"
 #include "Planet.h"
 #include "BlackHole.h"
+#include "StarIndex.h"
+#include "RoutePlanner.h"
+#include "MarketMatrix.h"
 #include "Galaxy.h"
 #include <QImage>
 #include <QPainter>
@@ -13,10 +16,65 @@
 #include <unordered_map>
 #include <cmath>
 
+class Galaxy;
+
+//Notified by Galaxy::parseDump(), lets a dump be evaluated while it is parsed
+class GalaxyParseObserver
+{
+public:
+	virtual ~GalaxyParseObserver() {}
+	virtual void parseStarted(const Galaxy& galaxy)=0;
+	//a star was added together with all its planets, ships and items
+	virtual void starParsed(const Galaxy& galaxy)=0;
+	virtual void parseFinished(const Galaxy& galaxy)=0;
+};
+
+//Fields decoded by Galaxy::parseDump(). Everything by default, the bulk
+//scoring leaves out what none of its presets reads.
+struct ParseProjection
+{
+	enum Field {
+		kEquipmentNames=0x1,//IName, cleaned with regular expressions: "Name" and "Bonus" columns
+		kMarkets=0x2,//goods of planets and ships: trade table, bases
+		kPlanetTechLevels=0x4,//"TL0".."TL19" columns
+		kAll=0x7
+	};
+	unsigned fields=kAll;
+	bool has(Field field) const
+	{
+		return fields & field;
+	}
+};
+
+//what the map shows for one star
+struct MapStar
+{
+	unsigned id=0;
+	QPointF position;//galaxy coordinates
+	QString name;
+	QColor color;//owner
+	QColor lineColor;
+	QString bases;//"RC,SB"
+	QString annotation;//ships and planets, rich text
+	bool blackHole=false;
+};
+
 class Galaxy
 {
 public:
 	explicit Galaxy();
+	void setProjection(const ParseProjection& projection)
+	{
+		_projection=projection;
+	}
+	const ParseProjection& projection() const
+	{
+		return _projection;
+	}
+	void setParseObserver(GalaxyParseObserver* observer)
+	{
+		_parseObserver=observer;
+	}
 	void parseDump(QTextStream& stream);
 	void clear();
 
@@ -27,6 +85,11 @@ public:
 	unsigned planetCount() const;
 
 	unsigned galaxyTechLevel() const;
+	//IDay of the dump, 0 if it has none
+	unsigned currentDay() const
+	{
+		return _currentDay;
+	}
 
 	void addEquipment(Equipment&& eq);
 	void addShip(const Ship&& ship);
@@ -35,6 +98,10 @@ public:
 	void addPlanet(const Planet&& planet);
 
 	QString starOwner(unsigned starId) const;
+	QString starName(unsigned starId) const
+	{
+		return starMap.at(starId).name();
+	}
 
 	unsigned marketsCount() const;
 	QString marketName(unsigned row) const;
@@ -46,9 +113,20 @@ public:
 	const GoodsArr& marketSale(unsigned row) const;
 	const GoodsArr& marketBuy(unsigned row) const;
 	unsigned marketId(unsigned row) const;
-	double marketDistFromPlayer(unsigned row) const;
+	//the planets come first, the ids of ships and planets may be the same
+	bool marketIsShip(unsigned row) const
+	{
+		return row>=planetMarkets.size();
+	}
+	unsigned marketStarId(unsigned row) const;
+	//the distances are measured from the star fromStarId, see playerStarId()
+	double marketDistance(unsigned row, unsigned fromStarId) const;
 	QString marketStarName(unsigned row) const;
 
+	const Equipment& equipment(unsigned row) const
+	{
+		return eqMap.at(eqVec.at(row));
+	}
 	unsigned equipmentId(unsigned row) const;
 	QString equipmentName(unsigned row) const;
 	QString equipmentType(unsigned row) const;
@@ -59,17 +137,33 @@ public:
 	QString equipmentLocationType(unsigned row) const;
 	QString equipmentLocationName(unsigned row) const;
 	int equipmentDepth(unsigned row) const;
+	//true once the location, the star and the player star of the item are parsed
+	bool equipmentResolved(unsigned row) const;
+	bool playerStarResolved() const
+	{
+		auto player=shipMap.find(0);
+		return player!=shipMap.end() && starMap.count(player->second.starId());
+	}
 	QString equipmentStarName(unsigned row) const;
-	double equipmentDistFromPlayer(unsigned row) const;
+	unsigned equipmentStarId(unsigned row) const;
+	double equipmentDistance(unsigned row, unsigned fromStarId) const;
 	QString equipmentStarOwner(unsigned row) const;
 	double equipmentDurability(unsigned row) const;
 	QString equipmentBonus(unsigned row) const;
 
 	unsigned blackHoleId(unsigned row) const;
 	QString blackHoleStar1(unsigned row) const;
-	float blackHoleStar1Distance(unsigned row) const;
+	unsigned blackHoleStar1Id(unsigned row) const
+	{
+		return blackHoles[row].star1Id();
+	}
+	unsigned blackHoleStar2Id(unsigned row) const
+	{
+		return blackHoles[row].star2Id();
+	}
+	float blackHoleStar1Distance(unsigned row, unsigned fromStarId) const;
 	QString blackHoleStar2(unsigned row) const;
-	float blackHoleStar2Distance(unsigned row) const;
+	float blackHoleStar2Distance(unsigned row, unsigned fromStarId) const;
 	int blackHoleTurnsToClose(unsigned row) const;
 	QString blackHoleNextLootChange(unsigned row) const;
 
@@ -77,14 +171,17 @@ public:
 	{
 		return planetMap.at(planetVec[row]);
 	}
-	float planetDistance(unsigned row) const
+	float planetDistance(unsigned row, unsigned fromStarId) const
 	{
-		unsigned planetStarId=planet(row).starId();
-		unsigned playerStarId=shipMap.at(0).starId();
-		QPointF playerPos=starMap.at(playerStarId).position();
-		QPointF planetPos=starMap.at(planetStarId).position();
-		QPointF delta=playerPos-planetPos;
-		return std::sqrt(std::pow(delta.x(), 2) + std::pow(delta.y(), 2));
+		return starDistance(fromStarId, planet(row).starId());
+	}
+	bool planetResolved(unsigned row) const
+	{
+		return playerStarResolved() && starMap.count(planet(row).starId());
+	}
+	unsigned planetStarId(unsigned row) const
+	{
+		return planet(row).starId();
 	}
 	QString planetStarName(unsigned row) const
 	{
@@ -109,10 +206,57 @@ public:
 	{
 		return _minSellPrice;
 	}
+	//goods and heat colours of the markets by row, filled once the dump is parsed
+	const MarketMatrix& marketMatrix() const
+	{
+		return _marketMatrix;
+	}
+	//positions of the stars for distances and neighbourhood queries
+	const StarIndex& starIndex() const
+	{
+		return _starIndex;
+	}
+	unsigned playerStarId() const
+	{
+		return shipMap.at(0).starId();
+	}
+	//the star, or the one of the player if it is negative or not in the galaxy
+	unsigned referenceStarId(int starId) const
+	{
+		return starId>=0 && _starIndex.contains(starId) ? starId : playerStarId();
+	}
+	double starDistance(unsigned fromStarId, unsigned starId) const
+	{
+		return _starIndex.distanceFrom(fromStarId, starId);
+	}
+	//engine the routes are planned for, keeps the black holes of the dump
+	void setRouteOptions(const RoutePlanner::Options& options)
+	{
+		_routePlanner.setOptions(options);
+	}
+	const RoutePlanner::Options& routeOptions() const
+	{
+		return _routePlanner.options();
+	}
+	//travelled through hyperjumps and black holes, the straight line until
+	//the dump is parsed; infinity for an unknown star or one out of reach
+	double routeDistance(unsigned fromStarId, unsigned starId) const;
+	bool routesResolved() const
+	{
+		return _routePlanner.isBuilt();
+	}
+	//from the first star to the last, empty until the dump is parsed or if
+	//the star is out of reach
+	std::vector<RoutePlanner::Hop> route(unsigned fromStarId, unsigned starId) const;
+	//"Star1 > Star2 >> Star3", >> through a black hole
+	QString routeText(unsigned fromStarId, unsigned starId) const;
+	std::vector<MapStar> mapStars() const;
+	const QRectF& mapRect() const
+	{
+		return galaxyMapRect;
+	}
+	//renders once without caching, see GalaxyMapRenderer
 	QImage map(const unsigned width=700, const int fontSize=8) const;
-private:
-	unsigned marketStarId(unsigned row) const;
-	unsigned equipmentStarId(unsigned row) const;
 private:
 	std::unordered_map<unsigned,Equipment> eqMap;
 	std::unordered_map<unsigned,Ship> shipMap;
@@ -123,7 +267,12 @@ private:
 	std::vector<unsigned> shipMarkets;
 	std::vector<unsigned> eqVec;
 	std::vector<unsigned> planetVec;
-	unsigned currentDay=0;
+	StarIndex _starIndex;
+	RoutePlanner _routePlanner;
+	MarketMatrix _marketMatrix;
+	unsigned _currentDay=0;
+	GalaxyParseObserver* _parseObserver=nullptr;
+	ParseProjection _projection;
 
 	mutable GoodsArr _maxBuyPrice;
 	mutable GoodsArr _minSellPrice;
@@ -131,4 +280,7 @@ private:
 	static const QMap<QString,QColor> _ownerToColor;//name,description
 };
 
+//reads the whole dump into buf, guessing between UTF-8 and Windows-1251
+bool readDumpFile(const QString& fileName, QString& buf);
+
 #endif // GALAXY_H
@@ -0,0 +1,356 @@
+#include "GalaxyMapRenderer.h"
+
+#include <QFontDatabase>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace
+{
+void hashCombine(uint &seed, uint value)
+{
+	seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+void hashCombine(uint &seed, const QPointF &pos)
+{
+	hashCombine(seed, qHash(pos.x()));
+	hashCombine(seed, qHash(pos.y()));
+}
+} // namespace
+
+GalaxyMapRenderer::GalaxyMapRenderer() : _font("Arial")
+{
+	// font.setStretch(QFont::SemiCondensed);
+	_inputHash.fill(0);
+	_imageHash.fill(0);
+}
+
+void GalaxyMapRenderer::setGalaxy(const Galaxy &galaxy)
+{
+	_stars = galaxy.mapStars();
+	_rect = galaxy.mapRect();
+	for (int layer = 0; layer < kLayerCount; layer++) {
+		_inputHash[layer] = layerHash(Layer(layer));
+	}
+	// keep the prepared texts that are still on the map
+	QHash<QString, QStaticText> texts;
+	for (const MapStar &star : _stars) {
+		auto it = _texts.constFind(star.annotation);
+		if (it != _texts.constEnd()) {
+			texts.insert(it.key(), it.value());
+		}
+	}
+	_texts.swap(texts);
+}
+
+uint GalaxyMapRenderer::layerHash(Layer layer) const
+{
+	uint seed = 0;
+	for (const MapStar &star : _stars) {
+		hashCombine(seed, star.position);
+		switch (layer) {
+		case kLabels:
+			hashCombine(seed, qHash(star.name));
+			hashCombine(seed, qHash(star.bases));
+			break;
+		case kStars:
+			hashCombine(seed, star.color.rgba());
+			hashCombine(seed, star.lineColor.rgba());
+			break;
+		case kAnnotations:
+			hashCombine(seed, qHash(star.annotation));
+			hashCombine(seed, star.lineColor.rgba());
+			break;
+		case kBlackHoles:
+			hashCombine(seed, star.blackHole);
+			break;
+		default:
+			break;
+		}
+	}
+	return seed;
+}
+
+GalaxyMapRenderer::Geometry GalaxyMapRenderer::geometry(unsigned width,
+							int fontSize) const
+{
+	Geometry g;
+	g.width = width;
+	g.fontSize = fontSize;
+	g.rect = _rect;
+	g.padding = fontSize * 4;
+	const unsigned netWidth = width - 2.0 * g.padding;
+	g.height = 2.0 * g.padding + netWidth * _rect.height() / _rect.width();
+	g.scale = double(netWidth) / _rect.width();
+	g.starR = 0.5 * fontSize;
+	g.right = g.width;
+	g.bottom = g.height;
+	return g;
+}
+
+QSize GalaxyMapRenderer::imageSize(unsigned width, int fontSize) const
+{
+	if (_rect.width() <= 0.0 || _rect.height() <= 0.0) {
+		return QSize();
+	}
+	const Geometry g = geometry(width, fontSize);
+	return QSize(g.width, g.height);
+}
+
+void GalaxyMapRenderer::prepare(int fontSize)
+{
+	if (_font.pointSize() != fontSize) {
+		_font.setPointSize(fontSize);
+		_texts.clear();
+	}
+	prepareAnnotations();
+}
+
+QImage GalaxyMapRenderer::tile(unsigned width, int fontSize,
+			       const QRect &rect) const
+{
+	QImage image(rect.size(), QImage::Format_ARGB32);
+	image.fill(Qt::black);
+	if (_rect.width() <= 0.0 || _rect.height() <= 0.0) {
+		return image;
+	}
+	Geometry g = geometry(width, fontSize);
+	g.left = rect.left();
+	g.right = rect.right() + 1;
+	g.top = rect.top();
+	g.bottom = rect.bottom() + 1;
+	QPainter p(&image);
+	p.setRenderHint(QPainter::Antialiasing, true);
+	p.setFont(_font);
+	for (int layer = 0; layer < kLayerCount; layer++) {
+		drawLayer(Layer(layer), p, g);
+	}
+	return image;
+}
+
+QString GalaxyMapRenderer::key() const
+{
+	QStringList hashes;
+	for (uint hash : _inputHash) {
+		hashes << QString::number(hash, 16);
+	}
+	return hashes.join('-');
+}
+
+const MapStar *GalaxyMapRenderer::star(unsigned id) const
+{
+	// Galaxy::mapStars() sorts them by id
+	auto it = std::lower_bound(
+		_stars.begin(), _stars.end(), id,
+		[](const MapStar &star, unsigned id) { return star.id < id; });
+	return it != _stars.end() && it->id == id ? &*it : nullptr;
+}
+
+QImage GalaxyMapRenderer::render(unsigned width, int fontSize)
+{
+	if (_rect.width() <= 0.0 || _rect.height() <= 0.0) {
+		return QImage();
+	}
+	const Geometry g = geometry(width, fontSize);
+	prepare(fontSize);
+
+	bool changed = _image.isNull() || !(_imageGeometry == g);
+	for (int layer = 0; layer < kLayerCount; layer++) {
+		CachedLayer &cached = _layers[layer];
+		changed = changed || _imageHash[layer] != _inputHash[layer];
+		if (!cached.image.isNull() && cached.inputHash == _inputHash[layer]
+		    && cached.geometry == g) {
+			continue;
+		}
+		cached.image = QImage(g.width, g.height,
+				      QImage::Format_ARGB32_Premultiplied);
+		cached.image.fill(Qt::transparent);
+		paintBands(cached.image, g,
+			   [this, layer](QPainter &p, const Geometry &band) {
+				   drawLayer(Layer(layer), p, band);
+			   });
+		cached.inputHash = _inputHash[layer];
+		cached.geometry = g;
+		changed = true;
+	}
+	if (!changed) {
+		return _image;
+	}
+
+	_image = QImage(g.width, g.height, QImage::Format_ARGB32);
+	_image.fill(Qt::black);
+	paintBands(_image, g, [this](QPainter &p, const Geometry &band) {
+		const QRect rows(0, band.top, band.width, band.bottom - band.top);
+		for (const CachedLayer &cached : _layers) {
+			p.drawImage(QPoint(0, 0), cached.image, rows);
+		}
+	});
+	_imageHash = _inputHash;
+	_imageGeometry = g;
+	return _image;
+}
+
+void GalaxyMapRenderer::paintBands(QImage &image, const Geometry &g,
+				   const BandPainter &paint) const
+{
+	struct Band {
+		uchar *bits;
+		int top;
+		int height;
+	};
+	// a few bands per thread even out the dense parts of the galaxy; text
+	// is only drawn from one thread where the fonts are not thread-safe
+	const int bandCount =
+		QFontDatabase::supportsThreadedFontRendering()
+			? 4 * QThreadPool::globalInstance()->maxThreadCount()
+			: 1;
+	const int bandHeight = std::max(64, int(g.height) / bandCount + 1);
+	const int bytesPerLine = image.bytesPerLine();
+	const QImage::Format format = image.format();
+	uchar *bits = image.bits();
+	std::vector<Band> bands;
+	for (int top = 0; top < int(g.height); top += bandHeight) {
+		bands.push_back({bits + top * bytesPerLine, top,
+				 std::min(bandHeight, int(g.height) - top)});
+	}
+	QtConcurrent::blockingMap(bands, [&](Band &band) {
+		// shares the rows of the image, nothing to copy back
+		QImage bandImage(band.bits, g.width, band.height, bytesPerLine,
+				 format);
+		Geometry bandGeometry = g;
+		bandGeometry.left = 0;
+		bandGeometry.right = g.width;
+		bandGeometry.top = band.top;
+		bandGeometry.bottom = band.top + band.height;
+		QPainter p(&bandImage);
+		p.setRenderHint(QPainter::Antialiasing, true);
+		p.setFont(_font);
+		paint(p, bandGeometry);
+	});
+}
+
+void GalaxyMapRenderer::drawLayer(Layer layer, QPainter &p,
+				  const Geometry &g) const
+{
+	switch (layer) {
+	case kLabels:
+		drawLabels(p, g);
+		break;
+	case kStars:
+		drawStars(p, g);
+		break;
+	case kAnnotations:
+		drawAnnotations(p, g);
+		break;
+	case kBlackHoles:
+		drawBlackHoles(p, g);
+		break;
+	default:
+		break;
+	}
+}
+
+void GalaxyMapRenderer::drawLabels(QPainter &p, const Geometry &g) const
+{
+	const int fontSize = g.fontSize;
+	const double starR = g.starR;
+	p.setPen(Qt::white);
+	for (const MapStar &star : _stars) {
+		if (!g.inBand(star.position)) {
+			continue;
+		}
+		const QPointF pos = g.toImage(star.position);
+		QRectF nameRect;
+		nameRect.setTopLeft(pos + QPointF(-6 * fontSize, starR));
+		nameRect.setBottomRight(
+			pos + QPointF(fontSize * 6, fontSize * 2 + starR));
+		p.drawText(nameRect, star.name,
+			   QTextOption(Qt::AlignHCenter | Qt::AlignTop));
+
+		const QString &basesStr = star.bases;
+		if (!basesStr.isEmpty()) {
+			QRectF basesRect =
+				QRectF(pos + QPointF(-8.0 * fontSize, -starR),
+				       pos + QPointF(-1.1 * starR, starR));
+			p.drawText(
+				basesRect, basesStr.left(2),
+				QTextOption(Qt::AlignRight | Qt::AlignVCenter));
+			if (basesStr.length() > 3) {
+				basesRect.translate(
+					8.0 * fontSize + 1.2 * starR, 0);
+				p.drawText(basesRect, basesStr.mid(3),
+					   QTextOption(Qt::AlignLeft
+						       | Qt::AlignVCenter));
+			}
+		}
+	}
+}
+
+void GalaxyMapRenderer::drawStars(QPainter &p, const Geometry &g) const
+{
+	const double starLineW = 0.5 * g.starR;
+	for (const MapStar &star : _stars) {
+		if (!g.inBand(star.position)) {
+			continue;
+		}
+		p.setBrush(QBrush(star.color, Qt::SolidPattern));
+		p.setPen(QPen(QBrush(star.lineColor), starLineW));
+		p.drawEllipse(g.toImage(star.position), g.starR, g.starR);
+	}
+}
+
+void GalaxyMapRenderer::drawAnnotations(QPainter &p, const Geometry &g) const
+{
+	const double starLineW = 0.5 * g.starR;
+	for (const MapStar &star : _stars) {
+		if (star.annotation.isEmpty()) {
+			continue;
+		}
+		// prepareAnnotations() runs before the bands, a text it missed is
+		// skipped rather than laid out by several threads at once
+		const auto it = _texts.constFind(star.annotation);
+		if (it == _texts.constEnd()) {
+			continue;
+		}
+		const QStaticText &planetsText = *it;
+		if (!g.inBand(star.position, 0.5 * planetsText.size().width())) {
+			continue;
+		}
+		// the text without a color of its own takes the star line color
+		p.setPen(QPen(QBrush(star.lineColor), starLineW));
+		// positioned by hand: a translated painter would make the
+		// shared text lay itself out again
+		QPointF topLeft = g.toImage(star.position);
+		topLeft.rx() -= 0.5 * planetsText.size().width();
+		topLeft.ry() -= 1.5 * g.fontSize + g.starR;
+		p.drawStaticText(topLeft, planetsText);
+	}
+}
+
+void GalaxyMapRenderer::drawBlackHoles(QPainter &p, const Geometry &g) const
+{
+	const double starR = g.starR;
+	p.setBrush(QBrush(QColor("darkblue"), Qt::SolidPattern));
+	p.setPen(QPen(QBrush(QColor("deepskyblue")), starR * 0.4));
+	for (const MapStar &star : _stars) {
+		if (star.blackHole && g.inBand(star.position)) {
+			p.drawEllipse(g.toImage(star.position)
+					      + QPointF(starR * 0.8, starR * 0.8),
+				      starR * 0.7, starR * 0.7);
+		}
+	}
+}
+
+void GalaxyMapRenderer::prepareAnnotations()
+{
+	for (const MapStar &star : _stars) {
+		if (star.annotation.isEmpty() || _texts.contains(star.annotation)) {
+			continue;
+		}
+		QStaticText staticText(star.annotation);
+		staticText.setTextFormat(Qt::RichText);
+		staticText.prepare(QTransform(), _font);
+		_texts.insert(star.annotation, staticText);
+	}
+}
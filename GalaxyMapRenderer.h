@@ -0,0 +1,117 @@
+#ifndef GALAXYMAPRENDERER_H
+#define GALAXYMAPRENDERER_H
+
+#include <QFont>
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QStaticText>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <vector>
+
+#include "Galaxy.h"
+
+//Draws the galaxy map from cached layers. Every layer is kept as an image
+//together with a hash of its inputs and is redrawn only when they change,
+//so a reload of a similar dump or a zoom does not rebuild the whole map.
+//The rich text of the annotations is prepared once per text and font size.
+//A layer is painted in horizontal bands on the global thread pool, each
+//band with its own QPainter on its own rows of the layer image.
+//Single tiles of the map are drawn straight from the stars, without the
+//layers, for views that show only a part of a big map.
+class GalaxyMapRenderer
+{
+public:
+	enum Layer {kLabels, kStars, kAnnotations, kBlackHoles, kLayerCount};
+
+	GalaxyMapRenderer();
+	//takes the stars of a freshly parsed galaxy
+	void setGalaxy(const Galaxy& galaxy);
+	QImage render(unsigned width, int fontSize);
+	//size of the image render() returns, empty without stars
+	QSize imageSize(unsigned width, int fontSize) const;
+	//sets the font and prepares the texts, tile() only reads them
+	void prepare(int fontSize);
+	//draws the part of the map of the given width within rect,
+	//may run in several threads at once after prepare(fontSize)
+	QImage tile(unsigned width, int fontSize, const QRect& rect) const;
+	//differs for galaxies that draw differently, names the tiles on disk
+	QString key() const;
+	//null if the star is not on the map
+	const MapStar* star(unsigned id) const;
+	//where a point of the galaxy is on the map of the given width
+	QPointF imagePos(unsigned width, int fontSize, const QPointF& galaxyPos) const
+	{
+		return geometry(width, fontSize).toImage(galaxyPos);
+	}
+
+private:
+	struct Geometry
+	{
+		unsigned width=0;
+		int fontSize=0;
+		unsigned padding=0;
+		unsigned height=0;
+		double scale=1.0;
+		double starR=0.0;
+		QRectF rect;
+		//part of the image being painted, not part of the cache key
+		int left=0;
+		int right=0;
+		int top=0;
+		int bottom=0;
+		bool operator==(const Geometry& o) const
+		{
+			return width==o.width && fontSize==o.fontSize && rect==o.rect;
+		}
+		QPointF toImage(const QPointF& galaxyPos) const
+		{
+			return (galaxyPos-rect.topLeft())*scale+QPointF(double(padding)-left, double(padding)-top);
+		}
+		//true if anything drawn around the star reaches the band,
+		//halfWidth is for texts wider than the labels
+		bool inBand(const QPointF& galaxyPos, double halfWidth=0.0) const
+		{
+			//labels below, annotations above the star, bases at the sides
+			const double extent=3.0*fontSize+starR;
+			const double xExtent=std::max(8.0*fontSize+2.0*starR, halfWidth);
+			const QPointF pos=toImage(galaxyPos);
+			return pos.y()+extent>=0 && pos.y()-extent<bottom-top &&
+			       pos.x()+xExtent>=0 && pos.x()-xExtent<right-left;
+		}
+	};
+	struct CachedLayer
+	{
+		QImage image;
+		uint inputHash=0;
+		Geometry geometry;
+	};
+
+	Geometry geometry(unsigned width, int fontSize) const;
+	uint layerHash(Layer layer) const;
+	using BandPainter=std::function<void(QPainter&, const Geometry&)>;
+	//splits the image into bands of rows and paints them in parallel
+	void paintBands(QImage& image, const Geometry& g, const BandPainter& paint) const;
+	void drawLayer(Layer layer, QPainter& p, const Geometry& g) const;
+	void drawLabels(QPainter& p, const Geometry& g) const;
+	void drawStars(QPainter& p, const Geometry& g) const;
+	void drawAnnotations(QPainter& p, const Geometry& g) const;
+	void drawBlackHoles(QPainter& p, const Geometry& g) const;
+	//prepares the texts before the bands only read them
+	void prepareAnnotations();
+
+	std::vector<MapStar> _stars;
+	QRectF _rect;
+	std::array<uint,kLayerCount> _inputHash;
+	std::array<CachedLayer,kLayerCount> _layers;
+	QImage _image;//the layers composed
+	std::array<uint,kLayerCount> _imageHash;
+	Geometry _imageGeometry;
+
+	QFont _font;
+	QHash<QString,QStaticText> _texts;//prepared for _font
+};
+
+#endif // GALAXYMAPRENDERER_H
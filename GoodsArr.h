@@ -2,6 +2,14 @@
 #define GOODSARR_H
 #include <QTextStream>
 #include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GOODSARR_SSE2
+#endif
+
+//Quantities or prices of the 8 goods. min() and max() take both halves of
+//the array in one SSE2 step each where it is available.
 class GoodsArr
 {
 public:
@@ -37,14 +45,31 @@ public:
     GoodsArr min(const GoodsArr& other) const
     {
 	GoodsArr result;
+#ifdef GOODSARR_SSE2
+	for(int h=0; h<2; h++){
+	    const __m128i a=half(h);
+	    const __m128i b=other.half(h);
+	    result.setHalf(h,select(lessThan(a,b),a,b));
+	}
+#else
 	for(int i=0; i<8; i++){
 	    result[i]=std::min(arr[i],other.arr[i]);
 	}
+#endif
 	return result;
     }
+    //min() of the goods with a non-zero sieve, the rest is kept
     GoodsArr min(const GoodsArr& other, const GoodsArr& sieve) const
     {
 	GoodsArr result;
+#ifdef GOODSARR_SSE2
+	for(int h=0; h<2; h++){
+	    const __m128i a=half(h);
+	    const __m128i b=other.half(h);
+	    const __m128i sieved=_mm_cmpeq_epi32(sieve.half(h),_mm_setzero_si128());
+	    result.setHalf(h,select(sieved,a,select(lessThan(a,b),a,b)));
+	}
+#else
 	for(int i=0; i<8; i++){
 	    if(sieve.arr[i])
 	    {
@@ -54,18 +79,48 @@ public:
 		result[i]=arr[i];
 	    }
 	}
+#endif
 	return result;
     }
     GoodsArr max(const GoodsArr& other) const
     {
 	GoodsArr result;
+#ifdef GOODSARR_SSE2
+	for(int h=0; h<2; h++){
+	    const __m128i a=half(h);
+	    const __m128i b=other.half(h);
+	    result.setHalf(h,select(lessThan(a,b),b,a));
+	}
+#else
 	for(int i=0; i<8; i++){
 	    result[i]=std::max(arr[i],other.arr[i]);
 	}
+#endif
 	return result;
     }
 
 private:
+#ifdef GOODSARR_SSE2
+    __m128i half(int h) const
+    {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(arr)+h);
+    }
+    void setHalf(int h, __m128i v)
+    {
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(arr)+h,v);
+    }
+    //a<b of unsigned lanes, SSE2 compares signed ones only
+    static __m128i lessThan(__m128i a, __m128i b)
+    {
+	const __m128i sign=_mm_set1_epi32(0x80000000);
+	return _mm_cmplt_epi32(_mm_xor_si128(a,sign),_mm_xor_si128(b,sign));
+    }
+    //a where the mask is set, b elsewhere
+    static __m128i select(__m128i mask, __m128i a, __m128i b)
+    {
+	return _mm_or_si128(_mm_and_si128(mask,a),_mm_andnot_si128(mask,b));
+    }
+#endif
     unsigned arr[8];
 };
 
@@ -0,0 +1,58 @@
+#ifndef HASHAGGREGATE_H
+#define HASHAGGREGATE_H
+
+#include <QHash>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+
+//Groups the rows 0..count-1 by keyOf(row) and folds the rows of a group into
+//its State with add(state,row). Big inputs are split into one range of rows
+//per thread, each range is aggregated into a table of its own and the
+//tables are merged in the order of the ranges with merge(state,later), so
+//the result doesn't depend on the number of threads. keyOf and add run in
+//the worker threads and may only read what nothing writes meanwhile, not the
+//caches of the galaxy. Below minRowsPerRange rows per range the threads cost
+//more than they save; rows that are expensive to read take a smaller one.
+template<typename Key, typename State, typename KeyOf, typename Add, typename Merge>
+QHash<Key,State> hashAggregate(int count, KeyOf keyOf, Add add, Merge merge,
+			       int minRowsPerRange=4096)
+{
+	auto aggregate=[&](int first, int last) {
+		QHash<Key,State> table;
+		for(int row=first; row<last; row++) {
+			add(table[keyOf(row)],row);
+		}
+		return table;
+	};
+	const int ranges=std::min(QThread::idealThreadCount(),count/minRowsPerRange);
+	if(ranges<=1) {
+		return aggregate(0,count);
+	}
+	QVector<int> rangeIds;
+	for(int range=0; range<ranges; range++) {
+		rangeIds<<range;
+	}
+	const QVector<QHash<Key,State>> tables=
+		QtConcurrent::blockingMapped<QVector<QHash<Key,State>>>(rangeIds,
+			[&](int range) {
+			return aggregate(int(qint64(count)*range/ranges),
+					 int(qint64(count)*(range+1)/ranges));
+		});
+	QHash<Key,State> result=tables.front();
+	for(int range=1; range<ranges; range++) {
+		for(auto i=tables[range].begin(); i!=tables[range].end(); ++i) {
+			auto found=result.find(i.key());
+			if(found==result.end()) {
+				result.insert(i.key(),i.value());
+			}
+			else {
+				merge(found.value(),i.value());
+			}
+		}
+	}
+	return result;
+}
+
+#endif // HASHAGGREGATE_H
@@ -0,0 +1,101 @@
+#include "LiteralSearch.h"
+#include "RowFilter.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LITERALSEARCH_SSE2
+#endif
+
+bool LiteralSearch::set(const QRegularExpression &re)
+{
+	_needles.clear();
+	QStringList literals;
+	_set = RowFilter::literals(re, literals);
+	if (!_set) {
+		return false;
+	}
+	_cs = re.patternOptions() & QRegularExpression::CaseInsensitiveOption
+		      ? Qt::CaseInsensitive
+		      : Qt::CaseSensitive;
+	for (const QString &literal : literals) {
+		Needle needle;
+		needle.text = literal;
+		if (!literal.isEmpty()) {
+			const QChar first = literal.at(0);
+			const QChar last = literal.at(literal.size() - 1);
+			needle.first[0] = needle.first[1] = first.unicode();
+			needle.last[0] = needle.last[1] = last.unicode();
+			if (_cs == Qt::CaseInsensitive) {
+				needle.first[0] = first.toLower().unicode();
+				needle.first[1] = first.toUpper().unicode();
+				needle.last[0] = last.toLower().unicode();
+				needle.last[1] = last.toUpper().unicode();
+			}
+		}
+		_needles.push_back(needle);
+	}
+	return true;
+}
+
+bool LiteralSearch::contains(const QString &text) const
+{
+	for (const Needle &needle : _needles) {
+		if (find(text, needle)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LiteralSearch::find(const QString &text, const Needle &needle) const
+{
+	const int size = needle.text.size();
+	if (size == 0) {
+		// "Gaal|" matches everything
+		return true;
+	}
+	const ushort *chars = text.utf16();
+	const int end = text.size() - size + 1;
+	auto matches = [&](int pos) {
+		return QStringRef(&text, pos, size).compare(needle.text, _cs) == 0;
+	};
+	int pos = 0;
+#ifdef LITERALSEARCH_SSE2
+	const __m128i first0 = _mm_set1_epi16(needle.first[0]);
+	const __m128i first1 = _mm_set1_epi16(needle.first[1]);
+	const __m128i last0 = _mm_set1_epi16(needle.last[0]);
+	const __m128i last1 = _mm_set1_epi16(needle.last[1]);
+	// the last block of eight also has to fit at the last character
+	for (; pos + 8 <= end; pos += 8) {
+		const __m128i head = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(chars + pos));
+		const __m128i tail = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(chars + pos + size - 1));
+		const __m128i candidates = _mm_and_si128(
+			_mm_or_si128(_mm_cmpeq_epi16(head, first0),
+				     _mm_cmpeq_epi16(head, first1)),
+			_mm_or_si128(_mm_cmpeq_epi16(tail, last0),
+				     _mm_cmpeq_epi16(tail, last1)));
+		// two bits per character
+		const int mask = _mm_movemask_epi8(candidates);
+		if (mask == 0) {
+			continue;
+		}
+		for (int i = 0; i < 8; i++) {
+			if ((mask >> (2 * i) & 1) && matches(pos + i)) {
+				return true;
+			}
+		}
+	}
+#endif
+	for (; pos < end; pos++) {
+		const ushort head = chars[pos];
+		const ushort tail = chars[pos + size - 1];
+		if ((head == needle.first[0] || head == needle.first[1])
+		    && (tail == needle.last[0] || tail == needle.last[1])
+		    && matches(pos)) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,39 @@
+#ifndef LITERALSEARCH_H
+#define LITERALSEARCH_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <vector>
+
+//Finds the literals of a filter like "Gaal|Nod" in a text without the regex
+//engine. The text is scanned eight characters at a time for the first and
+//last character of a literal in either case, and only those places are
+//compared in full.
+class LiteralSearch
+{
+public:
+	//false if the pattern uses regex syntax and has to be left to PCRE
+	bool set(const QRegularExpression& re);
+	bool isSet() const
+	{
+		return _set;
+	}
+	//true if the text has one of the literals
+	bool contains(const QString& text) const;
+
+private:
+	struct Needle
+	{
+		QString text;
+		//the first and last character as lower and upper case
+		ushort first[2];
+		ushort last[2];
+	};
+	bool find(const QString& text, const Needle& needle) const;
+
+	std::vector<Needle> _needles;
+	Qt::CaseSensitivity _cs=Qt::CaseSensitive;
+	bool _set=false;
+};
+
+#endif // LITERALSEARCH_H
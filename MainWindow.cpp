@@ -1,5 +1,8 @@
 #include "MainWindow.h"
 #include "ui_MainWindow.h"
+#include "TriagePipeline.h"
+#include "TourPlanner.h"
+#include "DumpIndex.h"
 
 
 #include <QSoundEffect>
@@ -17,6 +20,12 @@
 #include <QItemSelectionModel>
 #include <QClipboard>
 #include <QItemEditorFactory>
+#include <QInputDialog>
+#include <QElapsedTimer>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QListWidget>
+#include <QtConcurrent>
 
 #include <iostream>
 #include <fstream>
@@ -26,23 +35,6 @@
 #include "psapi.h"
 #endif
 
-QString tabSeparatedValues(const QAbstractItemModel &model)
-{
-	QString buf;
-	for (int c = 0; c < model.columnCount(); c++) {
-		buf += model.headerData(c, Qt::Horizontal).toString();
-		buf += '\t';
-	}
-	buf += '\n';
-	for (int r = 0; r < model.rowCount(); r++) {
-		for (int c = 0; c < model.columnCount(); c++) {
-			buf += model.data(model.index(r, c)).toString();
-			buf += '\t';
-		}
-		buf += '\n';
-	}
-	return buf;
-}
 QString bbSeparatedValues(const QItemSelectionModel *selectionModel)
 {
 	const QAbstractItemModel *model = selectionModel->model();
@@ -133,10 +125,11 @@ MainWindow::MainWindow(QWidget *parent)
 		}
 	});
 
-	ui->mapImageLabel->setBackgroundRole(QPalette::Base);
-	ui->scrollArea->setBackgroundRole(QPalette::Dark);
-
 	reloadMenu.addAction(ui->actionAutoReload);
+	reloadMenu.addAction(ui->actionArchiveDumps);
+	reloadMenu.addAction(ui->actionReplayArchive);
+	connect(ui->actionReplayArchive, &QAction::triggered, this,
+		&MainWindow::replayArchive);
 	QToolButton *reloadButton = static_cast<QToolButton *>(
 		ui->mainToolBar->widgetForAction(ui->actionReload));
 	reloadButton->setMenu(&reloadMenu);
@@ -152,7 +145,7 @@ MainWindow::MainWindow(QWidget *parent)
 	//_mapScaleSpinBox.setPrefix("x");
 	_mapScaleSpinBox.setMaximum(10000);
 	_mapScaleSpinBox.setSingleStep(50);
-	_mapScaleSpinBox.setToolTip(tr("Map width"));
+	_mapScaleSpinBox.setToolTip(tr("Map width, Ctrl+wheel on the map zooms in and out"));
 	_mapScaleSpinBox.setWhatsThis(tr("Map width"));
 	ui->mainToolBar->insertWidget(ui->mainToolBar->actions()[3],
 				      &_mapScaleSpinBox);
@@ -168,6 +161,17 @@ MainWindow::MainWindow(QWidget *parent)
 		SLOT(setMapFontSize(int)));
 	//	_mapFontSpinBox.setFixedWidth(40);
 
+	_mapOverlayComboBox.addItem(tr("No markers"));
+	_mapOverlayComboBox.addItem(tr("Equipment filter"));
+	_mapOverlayComboBox.addItem(tr("Planets filter"));
+	_mapOverlayComboBox.setToolTip(
+		tr("Mark the stars of the filtered rows on the map"));
+	ui->mainToolBar->insertWidget(ui->mainToolBar->actions()[5],
+				      &_mapOverlayComboBox);
+	connect(&_mapOverlayComboBox, SIGNAL(currentIndexChanged(int)), this,
+		SLOT(setMapOverlay(int)));
+	ui->mapView->setOverlay(&mapOverlay);
+
 	sound.setSource(QUrl::fromLocalFile("Click1.wav"));
 	sound.setVolume(1.0);
 
@@ -177,9 +181,19 @@ MainWindow::MainWindow(QWidget *parent)
 	tabifyDockWidget(ui->eqDockWidget, ui->bhDockWidget);
 	tabifyDockWidget(ui->bhDockWidget, ui->tradeDockWidget);
 	tabifyDockWidget(ui->tradeDockWidget, ui->imageDockWidget);
+	tabifyDockWidget(ui->bhDockWidget, ui->tourDockWidget);
+	tabifyDockWidget(ui->tradeDockWidget, ui->arbitrageDockWidget);
+	tabifyDockWidget(ui->bhDockWidget, ui->changesDockWidget);
+	tabifyDockWidget(ui->tradeDockWidget, ui->pivotDockWidget);
+	connect(ui->arbitrageRouteCheckBox, &QCheckBox::toggled, this,
+		&MainWindow::updateArbitrage);
 	ui->tradeDockWidget->raise();
 	readSettings();
 
+	tradeModel.setDiff(&dumpDiff);
+	eqModel.setDiff(&dumpDiff);
+	planetsModel.setDiff(&dumpDiff);
+	tradeModel.setPriceHistory(&priceHistory);
 	tradeProxyModel.setSourceModel(&tradeModel);
 	eqProxyModel.setSourceModel(&eqModel);
 	planetsProxyModel.setSourceModel(&planetsModel);
@@ -198,6 +212,9 @@ MainWindow::MainWindow(QWidget *parent)
 	// ui->tradeTableView->resizeRowsToContents();
 	ui->tradeTableView->setColumnWidth(0, tableFontWidth * 14);
 	ui->tradeTableView->setColumnWidth(1, tableFontWidth * 10);
+	connect(ui->tradeTableView->selectionModel(),
+		&QItemSelectionModel::currentChanged,
+		[this]() { updatePriceHistory(); });
 
 	ui->planetsTableView->setModel(&planetsProxyModel);
 	planetsHeaderView = new FilterHorizontalHeaderView(
@@ -226,7 +243,41 @@ MainWindow::MainWindow(QWidget *parent)
 	ui->equipmentTableView->setColumnWidth(12, tableFontWidth * 8); // Durab
 	ui->equipmentTableView->setColumnWidth(13,
 					       tableFontWidth * 48); // Bonus
+	ui->equipmentTableView->setColumnWidth(14, tableFontWidth * 8); // Route
+	// the route is appended for the presets, it is shown next to Dist.
+	eqHeaderView->moveSection(EquipmentTableModel::kRouteColumn, 11);
+	planetsHeaderView->moveSection(PlanetsTableModel::kRouteColumn, 3);
 	// ui->equipmentTableView->resizeRowsToContents();
+	addStarMenu(ui->equipmentTableView, &eqProxyModel);
+	addStarMenu(ui->planetsTableView, &planetsProxyModel);
+
+	pivotTimer.setSingleShot(true);
+	pivotTimer.setInterval(100);
+	connect(&pivotTimer, &QTimer::timeout, this, &MainWindow::updatePivot);
+	for (SortMultiFilterProxyModel *proxy :
+	     {&eqProxyModel, &planetsProxyModel}) {
+		auto later = [this]() { pivotTimer.start(); };
+		connect(proxy, &QAbstractItemModel::modelReset, later);
+		connect(proxy, &QAbstractItemModel::rowsInserted, later);
+		connect(proxy, &QAbstractItemModel::rowsRemoved, later);
+		connect(proxy, &QAbstractItemModel::layoutChanged, later);
+	}
+	connect(ui->pivotTableComboBox,
+		static_cast<void (QComboBox::*)(int)>(
+			&QComboBox::currentIndexChanged),
+		this, &MainWindow::fillPivotColumns);
+	for (QComboBox *combo :
+	     {ui->pivotGroupComboBox, ui->pivotAcrossComboBox,
+	      ui->pivotFunctionComboBox, ui->pivotValueComboBox}) {
+		connect(combo,
+			static_cast<void (QComboBox::*)(int)>(
+				&QComboBox::currentIndexChanged),
+			this, &MainWindow::updatePivot);
+	}
+	connect(ui->pivotDockWidget, &QDockWidget::visibilityChanged, this,
+		&MainWindow::updatePivot);
+	fillPivotColumns();
+
 	ui->equipmentTableView->verticalHeader()->setContextMenuPolicy(
 		Qt::CustomContextMenu);
 	connect(ui->equipmentTableView->verticalHeader(),
@@ -261,6 +312,8 @@ MainWindow::MainWindow(QWidget *parent)
 
 	ui->bhTableView->setModel(&bhModel);
 	ui->bhTableView->resizeColumnsToContents();
+	ui->bhTableView->horizontalHeader()->moveSection(6, 2);
+	ui->bhTableView->horizontalHeader()->moveSection(7, 5);
 
 	connect(planetsHeaderView, &FilterHorizontalHeaderView::presetSaved,
 		[&](const QVariantMap &preset, const QString &name) {
@@ -327,9 +380,21 @@ void MainWindow::readSettings()
 	_mapScaleSpinBox.setValue(mapWidth);
 	mapFontSize = std::max(0, settings.value("mapFontSize", 8).toInt());
 	_mapFontSpinBox.setValue(mapFontSize);
+	_mapOverlayComboBox.setCurrentIndex(
+		settings.value("mapOverlay", 0).toInt());
+	mapSaver.setCompression(settings.value("mapCompression", -1).toInt());
+	RoutePlanner::Options routeOptions;
+	routeOptions.jumpRange =
+		settings.value("routeJumpRange", routeOptions.jumpRange)
+			.toDouble();
+	routeOptions.speed =
+		settings.value("routeSpeed", routeOptions.speed).toDouble();
+	galaxy.setRouteOptions(routeOptions);
 
 	bool autoSaveReport = settings.value("autoSaveReport", false).toBool();
 	ui->actionAutoSaveReport->setChecked(autoSaveReport);
+	ui->actionArchiveDumps->setChecked(
+		settings.value("archiveDumps", false).toBool());
 	bool autoReload = settings.value("autoReload", false).toBool();
 	ui->actionAutoReload->setChecked(autoReload);
 	// ui->actionAutoReload->toggle();
@@ -341,22 +406,18 @@ void MainWindow::readSettings()
 	restoreState(settings.value("windowState").toByteArray());
 	std::cout << "rangersDir:" << rangersDir.toStdString() << std::endl;
 
-	QFile file("minRowsPreset.json");
-	if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-		if (!doc.isNull()) {
-			std::cout << "loading minRowsPreset.json" << std::endl;
-			QVariantMap minRowsJson = doc.toVariant().toMap();
-			using VarMapCI = QVariantMap::const_iterator;
-			for (VarMapCI i = minRowsJson.begin();
-			     i != minRowsJson.end(); ++i) {
-				minRowsPreset[i.key()] = i.value().toInt();
-				std::cout << i.key().toStdString() << ": "
-					  << i.value().toInt() << std::endl;
-			}
+	minRowsPreset = readMinRowsPreset("minRowsPreset.json");
+	if (!minRowsPreset.isEmpty()) {
+		std::cout << "loading minRowsPreset.json" << std::endl;
+		using MapStrIntCI = QMap<QString, int>::const_iterator;
+		for (MapStrIntCI i = minRowsPreset.begin();
+		     i != minRowsPreset.end(); ++i) {
+			std::cout << i.key().toStdString() << ": " << i.value()
+				  << std::endl;
 		}
 	}
 	scorers = readScorers("scorers.json");
+	report.setScorers(scorers);
 }
 
 void MainWindow::writeSettings() const
@@ -367,8 +428,14 @@ void MainWindow::writeSettings() const
 	settings.setValue("maxGenerationTime", maxGenerationTime);
 	settings.setValue("mapWidth", mapWidth);
 	settings.setValue("mapFontSize", mapFontSize);
+	settings.setValue("mapCompression", mapSaver.compression());
+	settings.setValue("mapOverlay", _mapOverlayComboBox.currentIndex());
+	settings.setValue("routeJumpRange",
+			  galaxy.routeOptions().jumpRange);
+	settings.setValue("routeSpeed", galaxy.routeOptions().speed);
 
 	settings.setValue("autoReload", ui->actionAutoReload->isChecked());
+	settings.setValue("archiveDumps", ui->actionArchiveDumps->isChecked());
 	settings.setValue("autoSaveReport",
 			  ui->actionAutoSaveReport->isChecked());
 
@@ -397,8 +464,7 @@ bool MainWindow::parseDump(const QString &filename)
 	if (!filename.isEmpty()) {
 		_filename = filename;
 	}
-	QFile file(_filename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+	if (!QFileInfo(_filename).isReadable()) {
 		showMessage(tr("File could not be open: ") + _filename);
 		return false;
 	}
@@ -414,21 +480,30 @@ bool MainWindow::parseDump(const QString &filename)
 		       + QFileInfo(_filename).baseName());
 
 	galaxy.clear();
-	QTextStream stream(&file);
-	QString buf = stream.read(500);
-	stream.seek(0);
-	if (buf.contains(QChar(65533))) {
-		stream.setCodec("Windows-1251");
-	}
-	std::cout << "File encoding: " << stream.codec()->name().toStdString()
-		  << ", " << filename.toStdString() << std::endl;
-	buf = stream.readAll();
+	QString buf;
+	if (!readDumpFile(_filename, buf)) {
+		showMessage(tr("File could not be open: ") + _filename);
+		return false;
+	}
+	if (ui->actionArchiveDumps->isChecked()) {
+		archiveDump(buf);
+	}
 	high_resolution_clock::time_point tReadEnd =
 		high_resolution_clock::now();
 	auto duration = duration_cast<milliseconds>(tReadEnd - tStart).count();
 	string timeTaken = "Reading the file took "
 			   + to_string(duration / 1000.0) + " s. ";
-	stream.setString(&buf);
+	return parseDumpText(buf, timeTaken);
+}
+
+bool MainWindow::parseDumpText(QString &buf, std::string timeTaken,
+				bool replay)
+{
+	using namespace std;
+	using namespace std::chrono;
+	high_resolution_clock::time_point tReadEnd =
+		high_resolution_clock::now();
+	QTextStream stream(&buf);
 	galaxy.parseDump(stream);
 	showMessage(
 		tr("Parsed %1 stars, %2 planets, %3 black holes, %4 ships and %5 items")
@@ -440,13 +515,37 @@ bool MainWindow::parseDump(const QString &filename)
 		5000);
 	high_resolution_clock::time_point tParseEnd =
 		high_resolution_clock::now();
-	duration = duration_cast<milliseconds>(tParseEnd - tReadEnd).count();
+	auto duration =
+		duration_cast<milliseconds>(tParseEnd - tReadEnd).count();
 	timeTaken += "Parsing - " + to_string(duration / 1000.0) + " s. ";
 
+	// the changes since the dump loaded before, if it is of the same game
+	if (replay) {
+		dumpDiff.clear();
+	} else {
+		DumpSnapshot snapshot(galaxy);
+		if (snapshot.sameGame(lastDump)) {
+			dumpDiff.compare(lastDump, snapshot);
+		} else {
+			dumpDiff.clear();
+			if (!priceHistory.open(priceHistoryDir, galaxy)) {
+				showMessage(
+					tr("Price history could not be open in ")
+					+ priceHistoryDir);
+			}
+		}
+		lastDump = std::move(snapshot);
+		priceHistory.append(galaxy);
+	}
+	updateChanges();
+
 	tradeModel.reload();
 	eqModel.reload();
 	bhModel.reload();
 	planetsModel.reload();
+	applyStarFilters();
+	updateArbitrage();
+	updatePriceHistory();
 	ui->tradeTableView->resizeColumnsToContents();
 	ui->planetsTableView->resizeColumnsToContents();
 	// ui->tradeTableView->resizeRowsToContents();
@@ -467,6 +566,8 @@ bool MainWindow::parseDump(const QString &filename)
 			   .count();
 	timeTaken += "Model update - " + to_string(duration / 1000.0) + " s. ";
 
+	mapRenderer.setGalaxy(galaxy);
+	ui->mapView->setRenderer(mapRenderer);
 	updateMap();
 	high_resolution_clock::time_point tMapEnd =
 		high_resolution_clock::now();
@@ -475,17 +576,72 @@ bool MainWindow::parseDump(const QString &filename)
 	timeTaken += "map update - " + to_string(duration / 1000.0) + " s. ";
 
 	duration = duration_cast<milliseconds>(high_resolution_clock::now()
-					       - tStart)
+					       - tReadEnd)
 			   .count();
-	timeTaken += "Total: " + to_string(duration / 1000.0) + " s.";
+	timeTaken += "Total after reading: " + to_string(duration / 1000.0)
+		     + " s.";
 	cout << timeTaken << endl;
 
-	if (ui->actionAutoSaveReport->isChecked()) {
+	// the report and the map of _filename belong to the live dump
+	if (!replay && ui->actionAutoSaveReport->isChecked()) {
 		saveReport();
 	}
 	return true;
 }
 
+void MainWindow::archiveDump(const QString &buf)
+{
+	if (!dumpArchive.isOpen()) {
+		QDir().mkpath(archiveDir);
+		const QString fileName =
+			archiveDir
+			+ QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss")
+			+ ".srda";
+		if (!dumpArchive.open(fileName)) {
+			showMessage(tr("Dump archive could not be open: ")
+				    + fileName);
+			return;
+		}
+	}
+	dumpArchive.append(buf, QFileInfo(_filename).fileName() + " "
+					+ _fileModified.toString(Qt::ISODate));
+}
+
+void MainWindow::replayArchive()
+{
+	const QString fileName = QFileDialog::getOpenFileName(
+		this, tr("Replay an archive"), archiveDir,
+		tr("Dump archives (*.srda)"));
+	if (fileName.isEmpty()) {
+		return;
+	}
+	DumpArchive archive;
+	if (!archive.open(fileName, DumpArchive::kReadOnly)
+	    || archive.count() == 0) {
+		showMessage(tr("Dump archive could not be open: ") + fileName);
+		return;
+	}
+	QStringList names;
+	for (int version = 0; version < archive.count(); version++) {
+		names << QString("%1. %2").arg(version + 1).arg(
+			archive.name(version));
+	}
+	bool ok;
+	const QString name =
+		QInputDialog::getItem(this, tr("Replay an archive"), tr("Dump:"),
+				      names, names.size() - 1, false, &ok);
+	QString buf;
+	if (!ok || !archive.read(names.indexOf(name), buf)) {
+		return;
+	}
+	reloadTimer.stop();
+	ui->actionAutoReload->setChecked(false);
+	galaxy.clear();
+	parseDumpText(buf, std::string(), true);
+	setWindowTitle(QStringLiteral("SRHDDumpReader - ")
+		       + QFileInfo(fileName).baseName() + " " + name);
+}
+
 bool MainWindow::openDump()
 {
 	QString fileName = QFileDialog::getOpenFileName(
@@ -518,11 +674,6 @@ void MainWindow::saveReport()
 	using namespace std::chrono;
 	high_resolution_clock::time_point tStart = high_resolution_clock::now();
 
-	QVariantMap oldEqPreset = eqHeaderView->preset();
-	QVariantMap oldPlPreset = planetsHeaderView->preset();
-	_reportSummary.clear();
-	_reportDepthList.clear();
-
 	QFileInfo fileInfo(_filename);
 	QString filename =
 		fileInfo.path() + '/' + fileInfo.completeBaseName() + ".report";
@@ -535,77 +686,16 @@ void MainWindow::saveReport()
 	}
 
 	if (!ofile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+		report.clear();
 		showMessage(tr("Could not create the report file ") + filename);
 		return;
 	}
 
-	QString bhBuf = tr("Black holes: %1\n").arg(galaxy.blackHoleCount());
-
-	// Bases
-	ui->tradeTableView->sortByColumn(2, Qt::AscendingOrder);
-	QString basesBuf = "Bases:\nname\tstar\tdistance\n";
-	for (int row = 0; row < tradeProxyModel.rowCount(); row++) {
-		double dist =
-			tradeProxyModel.data(tradeProxyModel.index(row, 2))
-				.toInt();
-		int size = tradeProxyModel.data(tradeProxyModel.index(row, 27))
-				   .toInt();
-		QString name =
-			tradeProxyModel.data(tradeProxyModel.index(row, 0))
-				.toString();
-		QString star =
-			tradeProxyModel.data(tradeProxyModel.index(row, 1))
-				.toString();
-		if (size == 0) { // Base, not planet
-			basesBuf += name + '\t' + star + '\t'
-				    + QString::number(dist);
-			basesBuf += '\n';
-			continue;
-		}
-	}
-
-	QString lastSummaryEntry;
-	// planets Presets
-	QString planetsBuf;
-	for (const QString &fileName : planetsReportPresets) {
-		planetsHeaderView->setPreset(loadPreset(fileName));
-		lastSummaryEntry = QFileInfo(fileName).baseName();
-		_reportSummary[lastSummaryEntry] = planetsProxyModel.rowCount();
-		lastSummaryEntry +=
-			": " + QString::number(planetsProxyModel.rowCount());
-		planetsBuf += lastSummaryEntry + '\n';
-		planetsBuf += tabSeparatedValues(planetsProxyModel);
-		planetsBuf += '\n';
-	}
-
-	// eq Presets
-	QString eqBuf;
-	for (const QString &fileName : eqReportPresets) {
-		eqHeaderView->setPreset(loadPreset(fileName));
-		lastSummaryEntry = QFileInfo(fileName).baseName();
-		_reportSummary[lastSummaryEntry] = eqProxyModel.rowCount();
-		QVector<int> depthList;
-		for (int proxyRow = 0; proxyRow < eqProxyModel.rowCount();
-		     ++proxyRow) {
-			auto pIndex = eqProxyModel.index(proxyRow, 0);
-			int sourceRow = eqProxyModel.mapToSource(pIndex).row();
-			depthList.push_back(galaxy.equipmentDepth(sourceRow));
-		}
-		_reportDepthList[lastSummaryEntry] = depthList;
-		lastSummaryEntry +=
-			": " + QString::number(eqProxyModel.rowCount());
-		eqBuf += lastSummaryEntry + '\n';
-		eqBuf += tabSeparatedValues(eqProxyModel);
-		eqBuf += '\n';
-	}
-	// restore presets
-	eqHeaderView->setPreset(oldEqPreset);
-	planetsHeaderView->setPreset(oldPlPreset);
+	report.build();
 
 	QTextStream out(&ofile); // we will serialize the data into the file
 	out.setCodec("UTF-8");
-	out << scoresSummary() + '\n' + planetsBuf + eqBuf + basesBuf + '\n'
-			+ bhBuf + '\n'; // serialize a string
+	out << report.text(); // serialize a string
 
 	statusBar()->showMessage(tr("Report saved: ") + filename);
 	auto duration = duration_cast<milliseconds>(high_resolution_clock::now()
@@ -758,13 +848,697 @@ void MainWindow::loadPresets()
 		std::cout << str.toLocal8Bit().toStdString() << std::endl;
 		str = presetDirEqReport + str;
 	}
+	report.setPresets(planetsReportPresets, eqReportPresets);
 }
 
 void MainWindow::updateMap()
 {
-	galaxyMap = galaxy.map(mapWidth, mapFontSize);
-	ui->mapImageLabel->setPixmap(QPixmap::fromImage(galaxyMap));
-	ui->mapImageLabel->resize(galaxyMap.size());
+	ui->mapView->setFontSize(mapFontSize);
+	ui->mapView->setMapWidth(mapWidth);
+}
+
+void MainWindow::setMapOverlay(int index)
+{
+	switch (index) {
+	case 1:
+		mapOverlay.setModel(&eqProxyModel, [this](int row) {
+			return galaxy.equipmentStarId(row);
+		});
+		break;
+	case 2:
+		mapOverlay.setModel(&planetsProxyModel, [this](int row) {
+			return galaxy.planetStarId(row);
+		});
+		break;
+	default:
+		mapOverlay.setModel(nullptr, MapOverlay::StarOfRow());
+		break;
+	}
+}
+
+void MainWindow::addStarMenu(QTableView *view,
+				   SortMultiFilterProxyModel *proxy)
+{
+	view->setContextMenuPolicy(Qt::CustomContextMenu);
+	connect(view, &QWidget::customContextMenuRequested, [=](QPoint pos) {
+		QMenu menu;
+		const QModelIndex index = view->indexAt(pos);
+		const unsigned starId =
+			proxy->data(index, RowFilter::StarIdRole).toUInt();
+		if (index.isValid() && galaxy.starIndex().contains(starId)) {
+			const QString starName = galaxy.starName(starId);
+			menu.addAction(tr("Only stars near %1...").arg(starName),
+				       [=]() { askStarFilter(proxy, starId); });
+			menu.addAction(tr("Only the stars nearest %1...").arg(starName),
+				       [=]() { askNearestStars(proxy, starId); });
+			menu.addAction(tr("Distances from %1").arg(starName),
+				       [=]() { setReferenceStar(starId); });
+		}
+		QAction *anyStar = menu.addAction(tr("Any star"), [=]() {
+			starFilters.remove(proxy);
+			proxy->unsetStars();
+		});
+		anyStar->setEnabled(starFilters.contains(proxy));
+		QAction *fromPlayer =
+			menu.addAction(tr("Distances from the player"),
+				       [=]() { setReferenceStar(-1); });
+		fromPlayer->setEnabled(referenceStar >= 0);
+		menu.addAction(tr("Route engine..."),
+			       [=]() { askRouteOptions(); });
+		QAction *limit = menu.addAction(
+			tr("Only the first rows..."), [=]() {
+				bool ok = false;
+				const int rows = QInputDialog::getInt(
+					this, tr("First rows"),
+					tr("Rows kept under the current sort, or the "
+					   "first ones of the table without it, "
+					   "0 for all:"),
+					proxy->limit(), 0, 1000000, 10, &ok);
+				if (ok) {
+					proxy->setLimit(rows);
+				}
+			});
+		limit->setCheckable(true);
+		limit->setChecked(proxy->limit() > 0);
+		if (proxy == &eqProxyModel) {
+			menu.addSeparator();
+			menu.addAction(tr("Tour of the selected treasures"),
+				       [=]() { planTreasureTour(); });
+			menu.addAction(tr("Search the dumps of this folder..."),
+				       [=]() { searchDumps(); });
+			QAction *skyline = menu.addAction(
+				tr("Skyline of the filter..."),
+				[=]() { askSkyline(); });
+			skyline->setCheckable(true);
+			skyline->setChecked(eqProxyModel.isSkyline());
+		}
+		menu.exec(view->viewport()->mapToGlobal(pos));
+	});
+}
+
+void MainWindow::askSkyline()
+{
+	if (eqProxyModel.isSkyline()) {
+		eqProxyModel.unsetSkyline();
+		return;
+	}
+	struct Choice {
+		QString name;
+		Skyline::Criterion criterion;
+	};
+	auto criterion = [](int col, bool larger,
+			    int role = Qt::DisplayRole) {
+		Skyline::Criterion c;
+		c.col = col;
+		c.role = role;
+		c.larger = larger;
+		return c;
+	};
+	const QVector<Choice> choices = {
+		{tr("Higher cost"), criterion(5, true)},
+		{tr("Higher TL"), criterion(6, true)},
+		{tr("Higher durability"), criterion(12, true)},
+		{tr("Smaller size"), criterion(3, false)},
+		{tr("Shorter distance"), criterion(EquipmentTableModel::kDistColumn, false)},
+		{tr("Shorter route"), criterion(EquipmentTableModel::kRouteColumn, false)},
+		{tr("Shallower treasure"),
+		 criterion(0, false, RowFilter::DepthRole)}};
+	if (skylineChoice.isEmpty()) {
+		skylineChoice = {0, 1, 4, 6};
+	}
+	QDialog dialog(this);
+	dialog.setWindowTitle(tr("Skyline"));
+	QVBoxLayout *layout = new QVBoxLayout(&dialog);
+	layout->addWidget(new QLabel(
+		tr("Keep the rows of the filter no other row beats on all of:")));
+	QListWidget *list = new QListWidget;
+	for (int i = 0; i < choices.size(); i++) {
+		QListWidgetItem *item = new QListWidgetItem(choices[i].name, list);
+		item->setCheckState(skylineChoice.contains(i) ? Qt::Checked
+							      : Qt::Unchecked);
+	}
+	layout->addWidget(list);
+	QDialogButtonBox *buttons = new QDialogButtonBox(
+		QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+	connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+	layout->addWidget(buttons);
+	if (dialog.exec() != QDialog::Accepted) {
+		return;
+	}
+	skylineChoice.clear();
+	QVector<Skyline::Criterion> criteria;
+	for (int i = 0; i < choices.size(); i++) {
+		if (list->item(i)->checkState() == Qt::Checked) {
+			skylineChoice.insert(i);
+			criteria << choices[i].criterion;
+		}
+	}
+	if (!criteria.isEmpty()) {
+		eqProxyModel.setSkyline(criteria);
+	}
+}
+
+void MainWindow::setReferenceStar(int starId)
+{
+	// the models tell the views which cells changed, the tables keep their
+	// selection and scroll position
+	referenceStar = starId;
+	tradeModel.setReferenceStar(starId);
+	eqModel.setReferenceStar(starId);
+	bhModel.setReferenceStar(starId);
+	planetsModel.setReferenceStar(starId);
+	showMessage(starId < 0 ? tr("Distances from the player")
+			       : tr("Distances from %1")
+					 .arg(galaxy.starName(starId)),
+		    5000);
+}
+
+QStringList MainWindow::goodNames() const
+{
+	return {tr("Food"),   tr("Meds"),     tr("Alcohol"), tr("Minerals"),
+		tr("Luxury"), tr("Technics"), tr("Weapons"), tr("Drugs")};
+}
+
+void MainWindow::updateChanges()
+{
+	const QStringList goods = goodNames();
+	QTableWidget *table = ui->changesTableWidget;
+	table->setSortingEnabled(false);
+	table->clear();
+	table->setColumnCount(5);
+	table->setHorizontalHeaderLabels({tr("Change"), tr("Name"), tr("Good"),
+					  tr("Before"), tr("After")});
+	table->setRowCount(dumpDiff.changes().size());
+	int row = 0;
+	for (const DumpDiff::Change &change : dumpDiff.changes()) {
+		table->setItem(row, 0, new QTableWidgetItem(
+					       DumpDiff::kindName(change.kind)));
+		table->setItem(row, 1, new QTableWidgetItem(change.name));
+		table->setItem(row, 2, new QTableWidgetItem(
+					       change.good < 0 ? QString()
+							       : goods.at(change.good)));
+		table->setItem(row, 3, new QTableWidgetItem(change.before));
+		table->setItem(row, 4, new QTableWidgetItem(change.after));
+		row++;
+	}
+	table->setSortingEnabled(true);
+	table->resizeColumnsToContents();
+	ui->changesDockWidget->setWindowTitle(
+		dumpDiff.isEmpty() ? tr("Changes")
+				   : tr("Changes (%1)").arg(row));
+}
+
+void MainWindow::updatePriceHistory()
+{
+	QLabel *label = ui->priceHistoryLabel;
+	const QModelIndex index =
+		tradeProxyModel.mapToSource(ui->tradeTableView->currentIndex());
+	quint64 marketKey;
+	int good;
+	if (!tradeModel.goodsCell(index, marketKey, good)) {
+		label->clear();
+		return;
+	}
+	const std::vector<PriceHistory::Point> sale =
+		priceHistory.range(marketKey, good, PriceHistory::kSale);
+	const std::vector<PriceHistory::Point> buy =
+		priceHistory.range(marketKey, good, PriceHistory::kBuy);
+	if (sale.size() < 2) {
+		label->setText(tr("%1: no price history here yet")
+				       .arg(goodNames().at(good)));
+		return;
+	}
+	unsigned minPrice = UINT_MAX, maxPrice = 0;
+	for (const auto *points : {&sale, &buy}) {
+		for (const PriceHistory::Point &point : *points) {
+			minPrice = std::min(minPrice, point.value);
+			maxPrice = std::max(maxPrice, point.value);
+		}
+	}
+	const unsigned firstDay = sale.front().day;
+	const unsigned lastDay = sale.back().day;
+	QImage image(std::max(label->width(), 100), 48,
+		     QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+	const double kx = double(image.width() - 1) / (lastDay - firstDay);
+	const double ky = double(image.height() - 14)
+			  / std::max(1u, maxPrice - minPrice);
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	auto sparkline = [&](const std::vector<PriceHistory::Point> &points,
+			     const QColor &color) {
+		QPolygonF line;
+		for (const PriceHistory::Point &point : points) {
+			line << QPointF((point.day - firstDay) * kx,
+					image.height() - 1
+						- (point.value - minPrice) * ky);
+		}
+		painter.setPen(QPen(color, 1.5));
+		painter.drawPolyline(line);
+	};
+	// the colours of the price cells
+	sparkline(sale, QColor(0, 163, 22));
+	sparkline(buy, QColor(0, 116, 224));
+	painter.setPen(palette().color(QPalette::WindowText));
+	painter.drawText(2, 10,
+			 tr("%1 %2..%3, days %4..%5")
+				 .arg(goodNames().at(good))
+				 .arg(minPrice)
+				 .arg(maxPrice)
+				 .arg(firstDay)
+				 .arg(lastDay));
+	painter.end();
+	label->setPixmap(QPixmap::fromImage(image));
+}
+
+void MainWindow::updateArbitrage()
+{
+	const bool byRoute = ui->arbitrageRouteCheckBox->isChecked();
+	const std::vector<MarketMatrix::Trade> trades =
+		galaxy.marketMatrix().bestTrades(
+			100, [&](unsigned from, unsigned to) {
+				return byRoute ? galaxy.routeDistance(from, to)
+					       : galaxy.starDistance(from, to);
+			});
+	const QStringList goods = goodNames();
+	QTableWidget *table = ui->arbitrageTableWidget;
+	// rows must not move while they are filled
+	table->setSortingEnabled(false);
+	table->clear();
+	table->setColumnCount(7);
+	table->setHorizontalHeaderLabels({tr("Good"), tr("Buy at"), tr("Sell at"),
+					  tr("Profit"), tr("Quantity"),
+					  tr("Dist."), tr("Per dist.")});
+	table->setRowCount(trades.size());
+	auto number = [](double value) {
+		QTableWidgetItem *item = new QTableWidgetItem;
+		item->setData(Qt::DisplayRole, value);
+		return item;
+	};
+	for (size_t i = 0; i < trades.size(); i++) {
+		const MarketMatrix::Trade &trade = trades[i];
+		table->setItem(i, 0, new QTableWidgetItem(goods.at(trade.good)));
+		table->setItem(i, 1, new QTableWidgetItem(
+					     galaxy.marketName(trade.fromRow)));
+		table->setItem(i, 2, new QTableWidgetItem(
+					     galaxy.marketName(trade.toRow)));
+		table->setItem(i, 3, number(trade.profit));
+		table->setItem(i, 4, number(trade.quantity));
+		table->setItem(i, 5, number(std::round(trade.distance)));
+		table->setItem(i, 6, number(std::round(trade.profitPerDistance
+						       * 10.0)
+					    / 10.0));
+	}
+	table->setSortingEnabled(true);
+	table->sortByColumn(6, Qt::DescendingOrder);
+	table->resizeColumnsToContents();
+}
+
+void MainWindow::fillPivotColumns()
+{
+	const bool equipment = ui->pivotTableComboBox->currentIndex() == 0;
+	const QAbstractItemModel *model =
+		equipment ? static_cast<QAbstractItemModel *>(&eqModel)
+			  : &planetsModel;
+	QComboBox *group = ui->pivotGroupComboBox;
+	QComboBox *across = ui->pivotAcrossComboBox;
+	QComboBox *value = ui->pivotValueComboBox;
+	for (QComboBox *combo : {group, across, value}) {
+		combo->blockSignals(true);
+		combo->clear();
+	}
+	across->addItem(tr("(none)"), -1);
+	for (int col = 0; col < model->columnCount(); col++) {
+		const QString name =
+			model->headerData(col, Qt::Horizontal).toString();
+		const int type =
+			model->headerData(col, Qt::Horizontal, Qt::UserRole)
+				.toInt();
+		if (type == SortMultiFilterProxyModel::ctNone) {
+			continue;
+		}
+		group->addItem(name, col);
+		across->addItem(name, col);
+		if (type != SortMultiFilterProxyModel::ctString) {
+			value->addItem(name, col);
+		}
+	}
+	// Star x Type, Owner x Economy
+	group->setCurrentIndex(group->findData(equipment ? 9 : 3));
+	across->setCurrentIndex(across->findData(equipment ? 2 : 7));
+	value->setCurrentIndex(value->findData(equipment ? 5 : 9));
+	for (QComboBox *combo : {group, across, value}) {
+		combo->blockSignals(false);
+	}
+	updatePivot();
+}
+
+void MainWindow::updatePivot()
+{
+	if (!ui->pivotDockWidget->isVisible()) {
+		return;
+	}
+	const bool equipment = ui->pivotTableComboBox->currentIndex() == 0;
+	const SortMultiFilterProxyModel *proxy =
+		equipment ? &eqProxyModel : &planetsProxyModel;
+	// Dist. and Route fill caches of the galaxy, they are read here
+	const QSet<int> callerCols =
+		equipment ? QSet<int>{EquipmentTableModel::kDistColumn,
+				      EquipmentTableModel::kRouteColumn}
+			  : QSet<int>{PlanetsTableModel::kDistColumn,
+				      PlanetsTableModel::kRouteColumn};
+	// the filtered rows, read from the source in the worker threads
+	std::vector<int> rows(proxy->rowCount());
+	for (size_t i = 0; i < rows.size(); i++) {
+		rows[i] = proxy->mapToSource(proxy->index(i, 0)).row();
+	}
+	const int acrossCol = ui->pivotAcrossComboBox->currentData().toInt();
+	const Pivot::Function function =
+		Pivot::Function(ui->pivotFunctionComboBox->currentIndex());
+	const QVariant valueCol = ui->pivotValueComboBox->currentData();
+	Pivot pivot;
+	pivot.run(*proxy->sourceModel(), rows,
+		  ui->pivotGroupComboBox->currentData().toInt(), acrossCol,
+		  function == Pivot::kCount || !valueCol.isValid()
+			  ? -1
+			  : valueCol.toInt(),
+		  callerCols);
+
+	QTableWidget *table = ui->pivotTableWidget;
+	table->setSortingEnabled(false);
+	table->clear();
+	const QStringList &across = pivot.across();
+	QStringList labels = across;
+	if (acrossCol < 0) {
+		labels = QStringList(ui->pivotFunctionComboBox->currentText());
+	}
+	labels.prepend(ui->pivotGroupComboBox->currentText());
+	table->setColumnCount(labels.size());
+	table->setHorizontalHeaderLabels(labels);
+	table->setRowCount(pivot.groups().size());
+	for (int row = 0; row < pivot.groups().size(); row++) {
+		const QString &group = pivot.groups()[row];
+		table->setItem(row, 0, new QTableWidgetItem(group));
+		for (int col = 0; col < across.size(); col++) {
+			const Pivot::Cell cell = pivot.cell(group, across[col]);
+			if (cell.count == 0) {
+				continue;
+			}
+			QTableWidgetItem *item = new QTableWidgetItem;
+			item->setData(Qt::DisplayRole,
+				      std::round(cell.value(function) * 10.0)
+					      / 10.0);
+			table->setItem(row, col + 1, item);
+		}
+	}
+	table->setSortingEnabled(true);
+	table->resizeColumnsToContents();
+}
+
+void MainWindow::askRouteOptions()
+{
+	RoutePlanner::Options options = galaxy.routeOptions();
+	bool ok = false;
+	options.jumpRange = QInputDialog::getDouble(
+		this, tr("Route engine"), tr("Jump range, 0 for any:"),
+		options.jumpRange, 0.0, 1000.0, 1, &ok);
+	if (!ok) {
+		return;
+	}
+	options.speed = QInputDialog::getDouble(
+		this, tr("Route engine"),
+		tr("Distance per day, for the black holes that close:"),
+		options.speed, 0.0, 1000.0, 1, &ok);
+	if (!ok) {
+		return;
+	}
+	galaxy.setRouteOptions(options);
+	// the Route columns are measured again
+	setReferenceStar(referenceStar);
+	if (ui->arbitrageRouteCheckBox->isChecked()) {
+		updateArbitrage();
+	}
+}
+
+void MainWindow::planTreasureTour()
+{
+	// the rows of the selected cells that lie in planets
+	std::vector<unsigned> rows;
+	QSet<int> seen;
+	for (const QModelIndex &index :
+	     ui->equipmentTableView->selectionModel()->selectedIndexes()) {
+		const int row = eqProxyModel.mapToSource(index).row();
+		if (!seen.contains(row) && galaxy.equipmentDepth(row) >= 0) {
+			seen.insert(row);
+			rows.push_back(row);
+		}
+	}
+	if (rows.empty()) {
+		showMessage(tr("Select planet treasures in the equipment table"),
+			    5000);
+		return;
+	}
+	// the depth penalties of the main score, if scorers.json has it
+	Scorer scorer;
+	if (!scorers.isEmpty()) {
+		scorer = scorers.value("TotalScore", scorers.first());
+	}
+	const std::vector<double> values = report.rowValues(rows, scorer);
+
+	// one stop per star, the start is the player
+	const unsigned start = galaxy.playerStarId();
+	std::vector<unsigned> stars;
+	std::vector<double> weights;
+	QMap<unsigned, int> starStop;
+	QMap<unsigned, QStringList> starItems;
+	int unreachable = 0;
+	for (size_t i = 0; i < rows.size(); i++) {
+		const unsigned starId = galaxy.equipmentStarId(rows[i]);
+		if (std::isinf(galaxy.routeDistance(start, starId))) {
+			unreachable++;
+			continue;
+		}
+		if (!starStop.contains(starId)) {
+			starStop[starId] = stars.size();
+			stars.push_back(starId);
+			weights.push_back(0.0);
+		}
+		weights[starStop[starId]] += values[i];
+		starItems[starId] << galaxy.equipmentName(rows[i]);
+	}
+	const int n = stars.size();
+	std::vector<double> distances((n + 1) * (n + 1));
+	for (int from = 0; from <= n; from++) {
+		const unsigned fromStar = from ? stars[from - 1] : start;
+		for (int to = 0; to <= n; to++) {
+			const unsigned toStar = to ? stars[to - 1] : start;
+			distances[from * (n + 1) + to] =
+				galaxy.routeDistance(fromStar, toStar);
+		}
+	}
+
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	const TourPlanner::Tour tour =
+		TourPlanner(distances, weights).solve(1000);
+	QApplication::restoreOverrideCursor();
+
+	QTableWidget *table = ui->tourTableWidget;
+	table->clear();
+	table->setColumnCount(5);
+	table->setHorizontalHeaderLabels({tr("Star"), tr("Leg"), tr("Route"),
+					  tr("Value"), tr("Items")});
+	table->setRowCount(tour.stops.size());
+	std::vector<RoutePlanner::Hop> path{{start, false}};
+	std::vector<unsigned> stops;
+	unsigned fromStar = start;
+	double travelled = 0.0;
+	for (size_t i = 0; i < tour.stops.size(); i++) {
+		const int stop = tour.stops[i] - 1;
+		const unsigned starId = stars[stop];
+		const double leg = galaxy.routeDistance(fromStar, starId);
+		travelled += leg;
+		const QStringList items = starItems.value(starId);
+		auto cell = [](const QString &text) {
+			return new QTableWidgetItem(text);
+		};
+		table->setItem(i, 0, cell(galaxy.starName(starId)));
+		table->setItem(i, 1, cell(QString::number(qRound(leg))));
+		table->setItem(i, 2, cell(QString::number(qRound(travelled))));
+		table->setItem(i, 3, cell(QString::number(weights[stop], 'g', 3)));
+		table->setItem(i, 4, cell(items.join(", ")));
+		table->item(i, 1)->setToolTip(galaxy.routeText(fromStar, starId));
+		// the first hop is the star of the last stop
+		const auto legPath = galaxy.route(fromStar, starId);
+		if (!legPath.empty()) {
+			path.insert(path.end(), legPath.begin() + 1,
+				    legPath.end());
+		}
+		stops.push_back(starId);
+		fromStar = starId;
+	}
+	table->resizeColumnsToContents();
+	ui->mapView->setTour(path, stops);
+	ui->tourDockWidget->raise();
+	QString message = tr("Tour of %1 stars, %2 long")
+				  .arg(tour.stops.size())
+				  .arg(qRound(tour.length));
+	if (unreachable > 0) {
+		message += tr(", %1 items out of reach").arg(unreachable);
+	}
+	showMessage(message, 10000);
+}
+
+void MainWindow::searchDumps()
+{
+	if (dumpFileList.isEmpty()) {
+		showMessage(tr("Open a dump of the folder to search first"), 5000);
+		return;
+	}
+	// the stars of "Only stars near" are ids of this galaxy
+	RowFilter filter = eqProxyModel.filter();
+	filter.unsetStars();
+	// the other dumps are measured from their player, like the index
+	double bound;
+	const bool distanceFiltered =
+		filter.min(EquipmentTableModel::kDistColumn, bound)
+		|| filter.max(EquipmentTableModel::kDistColumn, bound)
+		|| filter.min(EquipmentTableModel::kRouteColumn, bound)
+		|| filter.max(EquipmentTableModel::kRouteColumn, bound);
+	if (referenceStar >= 0 && distanceFiltered) {
+		showMessage(tr("Measure the distances from the player to search "
+			       "the dumps by Dist. or Route"),
+			    5000);
+		return;
+	}
+	bool ok;
+	const int maxDepth = QInputDialog::getInt(
+		this, tr("Search the dumps"),
+		tr("Deepest buried item, -1 for any item:"), -1, -1, 100000, 50,
+		&ok);
+	if (!ok) {
+		return;
+	}
+	QElapsedTimer timer;
+	timer.start();
+	DumpIndex index;
+	index.load(QFileInfo(dumpFileList.first()).path());
+	const int indexed = index.update(dumpFileList);
+	index.save();
+	const qint64 indexTime = timer.restart();
+
+	QVector<QString> candidates;
+	for (int dump : index.candidates(filter, maxDepth)) {
+		candidates << index.fileName(dump);
+	}
+	const qint64 queryTime = timer.restart();
+	const QVector<int> counts = QtConcurrent::blockingMapped<QVector<int>>(
+		candidates, [&filter, maxDepth](const QString &fileName) {
+			try {
+				return DumpIndex::matches(fileName, filter,
+							  maxDepth);
+			} catch (const std::exception &) {
+				return 0;
+			}
+		});
+	QStringList found;
+	QStringList foundFiles;
+	for (int i = 0; i < candidates.size(); i++) {
+		if (counts[i] > 0) {
+			found << tr("%1: %2 items")
+					 .arg(QFileInfo(candidates[i]).fileName())
+					 .arg(counts[i]);
+			foundFiles << candidates[i];
+		}
+	}
+	showMessage(tr("%1 dumps, %2 newly indexed in %3 ms; %4 candidates in "
+		       "%5 ms, %6 match after parsing them in %7 ms")
+			    .arg(index.count())
+			    .arg(indexed)
+			    .arg(indexTime)
+			    .arg(candidates.size())
+			    .arg(queryTime)
+			    .arg(found.size())
+			    .arg(timer.elapsed()));
+	if (found.isEmpty()) {
+		return;
+	}
+	const QString picked =
+		QInputDialog::getItem(this, tr("Search the dumps"),
+				      tr("Dumps with matching items:"), found, 0,
+				      false, &ok);
+	if (ok) {
+		const QString fileName = foundFiles.at(found.indexOf(picked));
+		currentDumpIndex = dumpFileList.indexOf(fileName);
+		updateDumpArrows();
+		parseDump(fileName);
+	}
+}
+
+void MainWindow::askStarFilter(SortMultiFilterProxyModel *proxy,
+			       unsigned starId)
+{
+	const QString starName = galaxy.starName(starId);
+	bool ok = false;
+	const double radius = QInputDialog::getDouble(
+		this, tr("Stars near %1").arg(starName), tr("Distance:"),
+		starFilters.value(proxy).radius, 0.0, 1000.0, 1, &ok);
+	if (ok) {
+		starFilters[proxy] = {starId, radius, 0};
+		applyStarFilters();
+		showMessage(tr("Rows within %1 of %2").arg(radius).arg(starName),
+			    5000);
+	}
+}
+
+void MainWindow::askNearestStars(SortMultiFilterProxyModel *proxy,
+				 unsigned starId)
+{
+	const QString starName = galaxy.starName(starId);
+	const StarFilter &last = starFilters.value(proxy);
+	bool ok = false;
+	const int count = QInputDialog::getInt(
+		this, tr("Stars nearest %1").arg(starName),
+		tr("Stars besides %1:").arg(starName),
+		last.nearest > 0 ? int(last.nearest) : 5, 1,
+		int(galaxy.starIndex().size()), 1, &ok);
+	if (ok) {
+		starFilters[proxy] = {starId, last.radius, unsigned(count)};
+		applyStarFilters();
+		showMessage(tr("Rows of %1 and the %2 stars nearest it")
+				    .arg(starName)
+				    .arg(count),
+			    5000);
+	}
+}
+
+void MainWindow::applyStarFilters()
+{
+	for (auto it = starFilters.begin(); it != starFilters.end();) {
+		SortMultiFilterProxyModel *proxy = it.key();
+		const StarFilter &filter = it.value();
+		if (!galaxy.starIndex().contains(filter.starId)) {
+			// a dump of another galaxy
+			proxy->unsetStars();
+			it = starFilters.erase(it);
+			continue;
+		}
+		QSet<unsigned> stars;
+		if (filter.nearest > 0) {
+			stars.insert(filter.starId);
+			for (unsigned id : galaxy.starIndex().nearest(
+				     filter.starId, filter.nearest)) {
+				stars.insert(id);
+			}
+		} else {
+			for (unsigned id : galaxy.starIndex().within(
+				     filter.starId, filter.radius)) {
+				stars.insert(id);
+			}
+		}
+		proxy->setStars(stars);
+		++it;
+	}
 }
 
 void MainWindow::updateDumpArrows()
@@ -788,59 +1562,19 @@ void MainWindow::saveMap()
 		QFileInfo fileInfo(_filename);
 		QString filename = fileInfo.path() + '/'
 				   + fileInfo.completeBaseName() + "_map.png";
-		if (QFileInfo(filename).exists()) {
-			QFile::remove(filename);
-		}
-		galaxyMap.save(filename);
+		// the view draws only tiles, the saved map is drawn whole
+		mapSaver.save(mapRenderer, mapWidth, mapFontSize, filename);
 	}
 }
 
 QVariantMap MainWindow::loadPreset(const QString &fileName) const
 {
-	QFile file(fileName);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		showMessage(tr("Unable to open file ") + file.errorString()
-			    + " " + file.fileName());
-		return QVariantMap();
-	}
-	QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-	if (doc.isNull()) {
-		showMessage(tr("Unable to parse JSON file"));
-		return QVariantMap();
+	QString error;
+	QVariantMap preset = ::loadPreset(fileName, &error);
+	if (!error.isEmpty()) {
+		showMessage(error);
 	}
-	return doc.toVariant().toMap();
-}
-
-QMap<QString, MainWindow::Scorer>
-MainWindow::readScorers(const QString &filename)
-{
-	QMap<QString, MainWindow::Scorer> scorers;
-	QFile scorersFile(filename);
-	if (!scorersFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		return scorers;
-	}
-	QJsonDocument doc = QJsonDocument::fromJson(scorersFile.readAll());
-	if (doc.isNull()) {
-		return scorers;
-	}
-	QVariantMap scorersJson = doc.toVariant().toMap();
-	using VarMapCI = QVariantMap::const_iterator;
-	for (VarMapCI i = scorersJson.begin(); i != scorersJson.end(); ++i) {
-		scorers[i.key()].read(i.value().toMap());
-	}
-	return scorers;
-}
-bool isUseless(const QMap<QString, int> &val, const QMap<QString, int> &min)
-{
-	using MapStrIntCI = QMap<QString, int>::const_iterator;
-	for (MapStrIntCI i = min.begin(); i != min.end(); ++i) {
-		if (val.value(i.key(), 0) < i.value()) {
-			std::cout << i.key().toStdString() << " < " << i.value()
-				  << std::endl;
-			return true;
-		}
-	}
-	return false;
+	return preset;
 }
 
 #ifdef _WIN32
@@ -1232,25 +1966,10 @@ void MainWindow::generateGalaxies()
 			saveReport();
 		}
 
-		QString timestamp = QDateTime::currentDateTime().toString(
-			"yyyyMMdd-hhmmss");
-
-		QString prefix = rangersDir + "/save/autodump";
-		if (isUseless(_reportSummary, minRowsPreset)) { // useless save
-			QFile::remove(prefix + ".txt");
-			QFile::remove(prefix + ".sav");
-			QFile::remove(prefix + ".report");
-			QFile::remove(prefix + "_map.png");
-		} else {
-			QFile::rename(prefix + ".txt",
-				      prefix + timestamp + ".txt");
-			QFile::rename(prefix + ".sav",
-				      prefix + timestamp + ".sav_");
-			QFile::rename(prefix + ".report",
-				      prefix + timestamp + ".report");
-			QFile::rename(prefix + "_map.png",
-				      prefix + timestamp + "_map.png");
-		}
+		// the map is moved along with the dump
+		mapSaver.waitForDone();
+		triageDumpFiles(rangersDir + "/save/autodump.txt",
+				!isUseless(report.summary(), minRowsPreset));
 
 		responsiveSleep(shortSleep * 20);
 		if (!simulateInput("s")) { // Esc
@@ -1278,31 +1997,6 @@ void MainWindow::generateGalaxies()
 #endif
 
 
-void MainWindow::Scorer::read(const QVariantMap &map)
-{
-	presetNames.clear();
-	weights.clear();
-	areBoolean.clear();
-	using VarMapCI = QVariantMap::const_iterator;
-	for (VarMapCI i = map.begin(); i != map.end(); ++i) {
-		QVariantMap score = i.value().toMap();
-		const QString &presetName = i.key();
-		double weight = score.value("weight").toDouble();
-		bool isBool = score.value("isBool").toBool();
-		bool penalize = score.value("depthPenalize").toBool();
-		addPreset(presetName, weight, isBool, penalize);
-	}
-}
-
-void MainWindow::Scorer::addPreset(const QString presetName, double weight,
-				   bool isBool, bool depthPenalize)
-{
-	presetNames.push_back(presetName);
-	weights.push_back(weight);
-	areBoolean.push_back(isBool);
-	depthPenalized.push_back(depthPenalize);
-}
-
 QStringList supportedColors()
 {
 	QVariantList colorNames;
@@ -36,6 +36,14 @@
 #include "PlanetsTableModel.h"
 #include "SortMultiFilterProxyModel.h"
 #include "FilterHorizontalHeaderView.h"
+#include "Report.h"
+#include "GalaxyMapRenderer.h"
+#include "MapOverlay.h"
+#include "MapSaver.h"
+#include "DumpDiff.h"
+#include "PriceHistory.h"
+#include "DumpArchive.h"
+#include "Pivot.h"
 
 namespace Ui {
 class MainWindow;
@@ -100,8 +108,12 @@ public slots:
 		mapFontSize=pt;
 		updateMap();
 	}
+	//marks the stars of the rows of a filter: 0 none, 1 equipment, 2 planets
+	void setMapOverlay(int index);
 	void loadNextDump();
 	void loadPreviousDump();
+	//parses a dump picked from an archive of a session
+	void replayArchive();
 
 #ifdef _WIN32
 public slots:
@@ -116,103 +128,65 @@ private slots:
 	void customHeaderMenuRequested(QPoint pos);
 
 private:
-	//    using Scorer=std::vector<std::tuple<QString,double,bool>>;
-	struct Scorer
-	{
-		void read(const QVariantMap& map);
-		void addPreset(const QString presetName,double weight,bool isBool,bool depthPenalize);
-		double score(const QMap<QString,int>& reportSummary,const QMap<QString,QVector<int>>& _reportDepthList) const
-		{
-			double score=0.0;
-			const double depthOffset=100;
-			for(int iPreset=0; iPreset<presetNames.size(); iPreset++)
-			{
-				double numRows=reportSummary.value(presetNames[iPreset]);
-				if(numRows==0.0) {continue;}
-				numRows=areBoolean[iPreset]?std::min(numRows,1.0):numRows;
-				if(depthPenalized[iPreset]) {
-					auto depthList=_reportDepthList.value(presetNames[iPreset]);
-					if(areBoolean[iPreset]) {
-						int minDepth=*std::min_element(depthList.constBegin(), depthList.constEnd());
-						minDepth+=depthOffset;
-						score+=1.0*weights[iPreset]/minDepth;
-					} else {
-						for(int depth: depthList) {
-							depth+=depthOffset;
-							score+=1.0*weights[iPreset]/depth;
-						}
-					}
-				} else {
-					score+=numRows*weights[iPreset];
-				}
-			}
-			return score;
-		}
-
-		QVector<QString> presetNames;
-		QVector<double> weights;
-		QVector<bool> areBoolean;
-		QVector<bool> depthPenalized;
-	};
 	void showMessage(const QString& str,int timeout=0) const
 	{
 		std::cout<<str.toStdString()<<std::endl;
 		statusBar()->showMessage(str,timeout);
 	}
 	bool openDump(const QString& fileName);
+	//a replayed dump is only shown: no report is saved, and the last dump
+	//and the price history stay those of the live dumps
+	bool parseDumpText(QString& buf, std::string timeTaken, bool replay=false);
+	//adds the dump to the archive of this session, opened with its first dump
+	void archiveDump(const QString& buf);
 	void savePreset(const QVariantMap& preset, const QString& fileName) const;
 	void generateGalaxies();
 	void responsiveSleep(int msec) const;
 	void loadPresets();
 	void updateMap();
 	void updateDumpArrows();
+	//right click on a row keeps the rows near its star or measures the
+	//distances from it
+	void addStarMenu(QTableView* view, SortMultiFilterProxyModel* proxy);
+	//-1 for the star of the player
+	void setReferenceStar(int starId);
+	QStringList goodNames() const;
+	//lists dumpDiff in the Changes dock
+	void updateChanges();
+	//sparkline of the prices of the current cell of the trade table
+	void updatePriceHistory();
+	//the best buy-here, sell-there pairs of the markets in the Arbitrage dock
+	void updateArbitrage();
+	//the columns of the table picked in the Pivot dock
+	void fillPivotColumns();
+	//groups the filtered rows of that table in the Pivot dock
+	void updatePivot();
+	//jump range and speed the Route columns are planned with
+	void askRouteOptions();
+	void askStarFilter(SortMultiFilterProxyModel* proxy, unsigned starId);
+	//keeps the rows of the star and of the stars nearest to it
+	void askNearestStars(SortMultiFilterProxyModel* proxy, unsigned starId);
+	//orders the stars of the selected treasures by their worth to the
+	//scorer and the way to them, shown in the Tour dock and on the map
+	void planTreasureTour();
+	//the dumps of the folder with items the equipment filter accepts, found
+	//with the index of the folder and checked by parsing them
+	void searchDumps();
+	//asks the criteria of the equipment skyline, or turns it off
+	void askSkyline();
+	//finds the stars of the filters in the current galaxy
+	void applyStarFilters();
 	void saveMap();
 	bool eventFilter(QObject* object, QEvent* event);
 	QVariantMap loadPreset(const QString &fileName) const;
-	QString scoresSummary(bool desc=true) const
-	{
-		QString summary;
-		using MapStrScorerCI=QMap<QString,Scorer>::const_iterator;
-		for (MapStrScorerCI i = scorers.begin(); i != scorers.end(); ++i)
-		{
-			if(desc) {summary+=i.key()+" = ";}
-			summary+=QString::number(i.value().score(_reportSummary,_reportDepthList))+
-				 "\t";
-		}
-		return summary;
-	}
-	QString scoresSummaryHeader() const
-	{
-		QString summary;
-		using MapStrScorerCI=QMap<QString,Scorer>::const_iterator;
-		for (MapStrScorerCI i = scorers.begin(); i != scorers.end(); ++i)
-		{
-			summary+=i.key()+"\t";
-		}
-		return summary;
-	}
 	QString reportSummary(bool desc=true) const
 	{
-		QString summary=scoresSummary(desc);
-		using MapStrIntCI=QMap<QString,int>::const_iterator;
-		for (MapStrIntCI i = _reportSummary.begin(); i != _reportSummary.end(); ++i)
-		{
-			if (desc) { summary+=i.key()+": ";}
-			summary+=QString::number(i.value())+"\t";
-		}
-		return summary;
+		return report.reportSummary(desc);
 	}
 	QString reportSummaryHeader() const
 	{
-		QString summary="dump name\t"+scoresSummaryHeader();
-		using MapStrIntCI=QMap<QString,int>::const_iterator;
-		for (MapStrIntCI i = _reportSummary.begin(); i != _reportSummary.end(); ++i)
-		{
-			summary+=i.key()+"\t";
-		}
-		return summary;
+		return report.reportSummaryHeader();
 	}
-	static QMap<QString,Scorer> readScorers(const QString &filename);
 
 private:
 	Ui::MainWindow *ui;
@@ -236,8 +210,10 @@ private:
 	FilterHorizontalHeaderView *planetsHeaderView;
 
 	QTimer reloadTimer;
+	QTimer pivotTimer;//a filter change sends several signals
 	QSpinBox _mapScaleSpinBox{this};
 	QSpinBox _mapFontSpinBox{this};
+	QComboBox _mapOverlayComboBox{this};
 
 	QMenu reloadMenu;
 	QMenu saveReportMenu;
@@ -249,6 +225,8 @@ private:
 	const QString presetDirEq="presets/equipment/";
 	const QString presetDirPlanetsReport="presets/planetsReport/";
 	const QString presetDirEqReport="presets/equipmentReport/";
+	const QString priceHistoryDir="priceHistory/";
+	const QString archiveDir="archive/";
 	int maxGenerationTime=120000;
 	int screenSaveLag=200;
 	int shortSleep=25;
@@ -257,13 +235,28 @@ private:
 	QStringList planetsReportPresets;
 	QStringList eqReportPresets;
 	QMap<QString,int> minRowsPreset;
-	QMap<QString,int> _reportSummary;
-	QMap<QString,QVector<int>> _reportDepthList;
 	QStringList dumpFileList;
 	int currentDumpIndex=-1;
-	QImage galaxyMap;
+	GalaxyMapRenderer mapRenderer;
+	MapSaver mapSaver;
+	MapOverlay mapOverlay;
+
+	struct StarFilter
+	{
+		unsigned starId=0;
+		double radius=45.0;
+		unsigned nearest=0;//count of the nearest stars, used instead of radius if set
+	};
+	QMap<SortMultiFilterProxyModel*,StarFilter> starFilters;
+	int referenceStar=-1;//of the Dist. columns
+	QSet<int> skylineChoice;//criteria ticked the last time
+	DumpSnapshot lastDump;
+	DumpDiff dumpDiff;//from lastDump to the galaxy
+	PriceHistory priceHistory;//of the game of lastDump
+	DumpArchive dumpArchive;
 
 	QMap<QString,Scorer> scorers;
+	Report report{&galaxy};
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,106 @@
+#include "MapOverlay.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+MapOverlay::MapOverlay(QObject *parent) : QObject(parent)
+{
+}
+
+void MapOverlay::setModel(const QAbstractProxyModel *proxy,
+			  const StarOfRow &starOfRow)
+{
+	if (_proxy) {
+		disconnect(_proxy, nullptr, this, nullptr);
+	}
+	_proxy = proxy;
+	_starOfRow = starOfRow;
+	if (_proxy) {
+		connect(_proxy, &QAbstractItemModel::rowsInserted, this,
+			&MapOverlay::rowsInserted);
+		connect(_proxy, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+			&MapOverlay::rowsAboutToBeRemoved);
+		connect(_proxy, &QAbstractItemModel::modelReset, this,
+			&MapOverlay::reset);
+		// sorting keeps the rows, a layout change may not
+		connect(_proxy, &QAbstractItemModel::layoutChanged, this,
+			&MapOverlay::reset);
+	}
+	reset();
+}
+
+int MapOverlay::maxCount() const
+{
+	int max = 0;
+	for (int count : _counts) {
+		max = std::max(max, count);
+	}
+	return max;
+}
+
+void MapOverlay::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+	if (parent.isValid()) {
+		return;
+	}
+	for (int row = first; row <= last; row++) {
+		add(row);
+	}
+	emit changed();
+}
+
+void MapOverlay::rowsAboutToBeRemoved(const QModelIndex &parent, int first,
+				      int last)
+{
+	if (parent.isValid()) {
+		return;
+	}
+	for (int row = first; row <= last; row++) {
+		remove(row);
+	}
+	emit changed();
+}
+
+void MapOverlay::reset()
+{
+	_rowStars.clear();
+	_counts.clear();
+	if (_proxy) {
+		const int rowCount = _proxy->rowCount();
+		_rowStars.reserve(rowCount);
+		for (int row = 0; row < rowCount; row++) {
+			add(row);
+		}
+	}
+	emit changed();
+}
+
+void MapOverlay::add(int proxyRow)
+{
+	const int sourceRow =
+		_proxy->mapToSource(_proxy->index(proxyRow, 0)).row();
+	try {
+		const unsigned star = _starOfRow(sourceRow);
+		_rowStars.insert(sourceRow, star);
+		_counts[star]++;
+	} catch (const std::out_of_range &e) {
+		std::cerr << "MapOverlay: no star for row " << sourceRow << ": "
+			  << e.what() << std::endl;
+	}
+}
+
+void MapOverlay::remove(int proxyRow)
+{
+	const int sourceRow =
+		_proxy->mapToSource(_proxy->index(proxyRow, 0)).row();
+	auto row = _rowStars.find(sourceRow);
+	if (row == _rowStars.end()) {
+		return;
+	}
+	auto count = _counts.find(row.value());
+	if (--count.value() <= 0) {
+		_counts.erase(count);
+	}
+	_rowStars.erase(row);
+}
@@ -0,0 +1,49 @@
+#ifndef MAPOVERLAY_H
+#define MAPOVERLAY_H
+
+#include <QAbstractProxyModel>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <functional>
+
+//Stars of the rows a filter accepts, with the number of those rows at each
+//star, for the markers on the map. Follows the rows the proxy inserts and
+//removes, so a changed filter touches only the rows that came or went.
+class MapOverlay : public QObject
+{
+	Q_OBJECT
+public:
+	//star of a row of the source model
+	using StarOfRow=std::function<unsigned(int)>;
+
+	explicit MapOverlay(QObject *parent=nullptr);
+	//a null proxy clears the overlay
+	void setModel(const QAbstractProxyModel* proxy, const StarOfRow& starOfRow);
+	const QHash<unsigned,int>& counts() const
+	{
+		return _counts;
+	}
+	int maxCount() const;
+
+signals:
+	void changed();
+
+private slots:
+	void rowsInserted(const QModelIndex& parent, int first, int last);
+	void rowsAboutToBeRemoved(const QModelIndex& parent, int first, int last);
+	void reset();
+
+private:
+	void add(int proxyRow);
+	void remove(int proxyRow);
+
+	QPointer<const QAbstractProxyModel> _proxy;
+	StarOfRow _starOfRow;
+	//the star a source row was counted at, the galaxy may be reparsed
+	//before the row is removed
+	QHash<int,unsigned> _rowStars;
+	QHash<unsigned,int> _counts;
+};
+
+#endif // MAPOVERLAY_H
@@ -0,0 +1,64 @@
+#include "MapSaver.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QtConcurrent>
+#include <iostream>
+
+MapSaver::MapSaver(QObject *parent) : QObject(parent)
+{
+	// the maps are written in the order they were saved
+	_pool.setMaxThreadCount(1);
+}
+
+MapSaver::~MapSaver()
+{
+	_pool.waitForDone();
+}
+
+bool MapSaver::save(GalaxyMapRenderer &renderer, unsigned width, int fontSize,
+		    const QString &fileName)
+{
+	const QString inputs = QString("%1/%2_%3")
+				       .arg(renderer.key())
+				       .arg(width)
+				       .arg(fontSize);
+	// a map written before may have been moved away by the triage since
+	if (_saved.value(fileName) == inputs && QFileInfo::exists(fileName)) {
+		return false;
+	}
+	const QImage image = renderer.render(width, fontSize);
+	if (image.isNull()) {
+		return false;
+	}
+	// QImageWriter takes a quality, the PNG handler turns it into the
+	// zlib level (100-quality)*9/91
+	const int quality =
+		_compression < 0 ? -1 : 100 - (_compression * 91 + 8) / 9;
+	QtConcurrent::run(&_pool, [this, image, fileName, inputs, quality] {
+		const QString tmpName = fileName + ".tmp";
+		QImageWriter writer(tmpName, "PNG");
+		writer.setQuality(quality);
+		if (!writer.write(image)) {
+			std::cerr << "Could not save the map "
+				  << fileName.toStdString() << ": "
+				  << writer.errorString().toStdString()
+				  << std::endl;
+			QFile::remove(tmpName);
+			return;
+		}
+		QFile::remove(fileName);
+		if (!QFile::rename(tmpName, fileName)) {
+			std::cerr << "Could not save the map "
+				  << fileName.toStdString() << std::endl;
+			QFile::remove(tmpName);
+			return;
+		}
+		// a failed map is written again the next time
+		QMetaObject::invokeMethod(this, "written", Qt::QueuedConnection,
+					  Q_ARG(QString, fileName),
+					  Q_ARG(QString, inputs));
+	});
+	return true;
+}
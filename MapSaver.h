@@ -0,0 +1,51 @@
+#ifndef MAPSAVER_H
+#define MAPSAVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+#include "GalaxyMapRenderer.h"
+
+//Writes the galaxy maps next to the dumps. The PNG is encoded in a thread
+//of its own, one map after another, and only if the stars, the width or the
+//font size changed since the map was written to that file, so an auto
+//reload of an unchanged dump does not encode the same map again.
+class MapSaver : public QObject
+{
+	Q_OBJECT
+public:
+	explicit MapSaver(QObject *parent = nullptr);
+	~MapSaver();
+	//zlib level, 0 is the fastest, 9 the smallest, -1 the library default
+	void setCompression(int level)
+	{
+		_compression=qBound(-1, level, 9);
+	}
+	int compression() const
+	{
+		return _compression;
+	}
+	//returns false if the file is up to date and nothing was queued
+	bool save(GalaxyMapRenderer& renderer, unsigned width, int fontSize, const QString& fileName);
+	//waits for the queued maps, e.g. before their files are moved
+	void waitForDone()
+	{
+		_pool.waitForDone();
+	}
+
+private slots:
+	//queued by the writer thread once the map is in place
+	void written(const QString& fileName, const QString& inputs)
+	{
+		_saved[fileName]=inputs;
+	}
+
+private:
+	QThreadPool _pool;
+	QHash<QString,QString> _saved;//file name -> inputs of the map written there, set once it is
+	int _compression=-1;
+};
+
+#endif // MAPSAVER_H
@@ -0,0 +1,123 @@
+#include "MapTileCache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <vector>
+
+MapTileCache::MapTileCache(int maxMemory, const QString &diskDir)
+	: _memory(maxMemory), _diskDir(diskDir)
+{
+}
+
+QString MapTileCache::key(const QString &galaxyKey, unsigned width,
+			  int fontSize, int col, int row)
+{
+	return QString("%1/%2_%3/%4_%5")
+		.arg(galaxyKey)
+		.arg(width)
+		.arg(fontSize)
+		.arg(col)
+		.arg(row);
+}
+
+QImage MapTileCache::find(const QString &key)
+{
+	const QImage *tile = _memory.object(key);
+	return tile ? *tile : QImage();
+}
+
+void MapTileCache::insert(const QString &key, const QImage &tile)
+{
+	const int cost = std::max(1, tile.bytesPerLine() * tile.height() / 1024);
+	_memory.insert(key, new QImage(tile), cost);
+}
+
+QString MapTileCache::fileName(const QString &key) const
+{
+	return _diskDir + '/' + key + ".png";
+}
+
+QImage MapTileCache::load(const QString &key) const
+{
+	if (_diskDir.isEmpty()) {
+		return QImage();
+	}
+	QImage tile;
+	tile.load(fileName(key), "PNG");
+	return tile;
+}
+
+void MapTileCache::save(const QString &key, const QImage &tile) const
+{
+	if (_diskDir.isEmpty()) {
+		return;
+	}
+	const QString name = fileName(key);
+	QDir().mkpath(QFileInfo(name).path());
+	// written under another name, a tile loaded meanwhile is never half
+	// written
+	const QString tmpName = name + ".tmp";
+	if (tile.save(tmpName, "PNG")) {
+		QFile::remove(name);
+		QFile::rename(tmpName, name);
+	} else {
+		QFile::remove(tmpName);
+	}
+}
+
+void MapTileCache::touch(const QString &galaxyKey) const
+{
+	if (_diskDir.isEmpty()) {
+		return;
+	}
+	const QString path = _diskDir + '/' + galaxyKey;
+	QDir().mkpath(path);
+	QFile(path + "/viewed").open(QIODevice::WriteOnly);
+}
+
+void MapTileCache::pruneDisk(qint64 maxBytes) const
+{
+	if (_diskDir.isEmpty()) {
+		return;
+	}
+	struct GalaxyDir {
+		QString path;
+		QDateTime viewed;
+		qint64 bytes;
+	};
+	std::vector<GalaxyDir> galaxyDirs;
+	qint64 total = 0;
+	const QFileInfoList infoList =
+		QDir(_diskDir).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+	for (const QFileInfo &info : infoList) {
+		GalaxyDir galaxyDir{info.absoluteFilePath(), info.lastModified(),
+				    0};
+		QFileInfo viewed(galaxyDir.path + "/viewed");
+		if (viewed.exists()) {
+			galaxyDir.viewed = viewed.lastModified();
+		}
+		QDirIterator it(galaxyDir.path, QDir::Files,
+				QDirIterator::Subdirectories);
+		while (it.hasNext()) {
+			it.next();
+			galaxyDir.bytes += it.fileInfo().size();
+		}
+		total += galaxyDir.bytes;
+		galaxyDirs.push_back(galaxyDir);
+	}
+	std::sort(galaxyDirs.begin(), galaxyDirs.end(),
+		  [](const GalaxyDir &a, const GalaxyDir &b) {
+			  return a.viewed < b.viewed;
+		  });
+	for (const GalaxyDir &galaxyDir : galaxyDirs) {
+		if (total <= maxBytes) {
+			break;
+		}
+		QDir(galaxyDir.path).removeRecursively();
+		total -= galaxyDir.bytes;
+	}
+}
@@ -0,0 +1,45 @@
+#ifndef MAPTILECACHE_H
+#define MAPTILECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QString>
+
+//Tiles of the galaxy map, the recently used ones in memory, all of them as
+//PNG files in a directory per galaxy. A key names the galaxy, the map width,
+//the font size and the place of the tile, so a reloaded dump of the same
+//galaxy finds its tiles on disk.
+class MapTileCache
+{
+public:
+	static const int kTileSize=256;
+
+	//maxMemory in KiB, an empty diskDir keeps the tiles in memory only
+	explicit MapTileCache(int maxMemory=128*1024, const QString& diskDir=QString());
+
+	static QString key(const QString& galaxyKey, unsigned width, int fontSize, int col, int row);
+	//null if the tile is not in memory, marks it as recently used
+	QImage find(const QString& key);
+	void insert(const QString& key, const QImage& tile);
+	void clear()
+	{
+		_memory.clear();
+	}
+
+	//the disk part does not touch the memory and may run in other threads
+	QImage load(const QString& key) const;
+	void save(const QString& key, const QImage& tile) const;
+	//marks the galaxy as viewed now for pruneDisk()
+	void touch(const QString& galaxyKey) const;
+	//removes the tiles of the galaxies not viewed for the longest time
+	//until the directory takes at most maxBytes
+	void pruneDisk(qint64 maxBytes) const;
+
+private:
+	QString fileName(const QString& key) const;
+
+	QCache<QString,QImage> _memory;
+	const QString _diskDir;
+};
+
+#endif // MAPTILECACHE_H
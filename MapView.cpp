@@ -0,0 +1,343 @@
+#include "MapView.h"
+
+#include <QFontDatabase>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QWheelEvent>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const qint64 kDiskCacheBytes = 512 * 1024 * 1024;
+
+QString tileCacheDir()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+	       + "/mapTiles";
+}
+} // namespace
+
+MapView::MapView(QWidget *parent)
+	: QAbstractScrollArea(parent), _cache(128 * 1024, tileCacheDir())
+{
+	viewport()->setBackgroundRole(QPalette::Dark);
+	horizontalScrollBar()->setSingleStep(MapTileCache::kTileSize / 8);
+	verticalScrollBar()->setSingleStep(MapTileCache::kTileSize / 8);
+	// leaves a core to the GUI; the tiles draw text, one at a time where
+	// the fonts are not thread-safe
+	_pool.setMaxThreadCount(
+		QFontDatabase::supportsThreadedFontRendering()
+			? std::max(1, QThread::idealThreadCount() - 1)
+			: 1);
+	// the tiles of old galaxies are trimmed once per start, by a cache of
+	// its own, the view may be gone before it is done
+	const QString dir = tileCacheDir();
+	QtConcurrent::run([dir] { MapTileCache(0, dir).pruneDisk(kDiskCacheBytes); });
+}
+
+MapView::~MapView()
+{
+	// the running tiles refer to this view
+	_pool.clear();
+	_pool.waitForDone();
+}
+
+void MapView::setRenderer(const GalaxyMapRenderer &renderer)
+{
+	auto copy = std::make_shared<GalaxyMapRenderer>(renderer);
+	copy->prepare(_fontSize);
+	_renderer = copy;
+	_galaxyKey = copy->key();
+	_cache.touch(_galaxyKey);
+	cancelRequests();
+	updateLevel(viewport()->rect().center());
+}
+
+void MapView::setMapWidth(unsigned width)
+{
+	if (width == _mapWidth) {
+		return;
+	}
+	_mapWidth = width;
+	cancelRequests();
+	updateLevel(viewport()->rect().center());
+}
+
+void MapView::setFontSize(int fontSize)
+{
+	if (fontSize == _fontSize) {
+		return;
+	}
+	_fontSize = fontSize;
+	if (_renderer) {
+		// the tiles still being drawn read the old texts
+		auto copy = std::make_shared<GalaxyMapRenderer>(*_renderer);
+		copy->prepare(_fontSize);
+		_renderer = copy;
+	}
+	cancelRequests();
+	updateLevel(viewport()->rect().center());
+}
+
+void MapView::setOverlay(const MapOverlay *overlay)
+{
+	if (_overlay) {
+		disconnect(_overlay, nullptr, viewport(), nullptr);
+	}
+	_overlay = overlay;
+	if (_overlay) {
+		connect(_overlay, &MapOverlay::changed, viewport(),
+			static_cast<void (QWidget::*)()>(&QWidget::update));
+	}
+	viewport()->update();
+}
+
+void MapView::setTour(const std::vector<RoutePlanner::Hop> &path,
+			const std::vector<unsigned> &stops)
+{
+	_tourPath = path;
+	_tourStops = stops;
+	viewport()->update();
+}
+
+void MapView::setZoom(int zoom, const QPoint &anchor)
+{
+	zoom = qBound(kMinZoom, zoom, kMaxZoom);
+	if (zoom == _zoom) {
+		return;
+	}
+	_zoom = zoom;
+	cancelRequests();
+	updateLevel(anchor.isNull() ? viewport()->rect().center() : anchor);
+}
+
+unsigned MapView::levelWidth() const
+{
+	const double width = std::ldexp(double(_mapWidth), _zoom);
+	// wider than the padding around the stars
+	return std::max<unsigned>({unsigned(width), MapTileCache::kTileSize,
+				   8u * _fontSize + 16});
+}
+
+QPoint MapView::mapOrigin() const
+{
+	// a map smaller than the view is centered
+	const QSize viewSize = viewport()->size();
+	return QPoint(std::max(0, (viewSize.width() - _levelSize.width()) / 2)
+			      - horizontalScrollBar()->value(),
+		      std::max(0, (viewSize.height() - _levelSize.height()) / 2)
+			      - verticalScrollBar()->value());
+}
+
+void MapView::updateLevel(const QPoint &anchor)
+{
+	// the point of the map under the anchor stays there
+	QPointF fraction(0.5, 0.5);
+	if (!_levelSize.isEmpty()) {
+		const QPoint mapPos = anchor - mapOrigin();
+		fraction = QPointF(double(mapPos.x()) / _levelSize.width(),
+				   double(mapPos.y()) / _levelSize.height());
+	}
+	_levelSize = _renderer ? _renderer->imageSize(levelWidth(), _fontSize)
+			       : QSize();
+	const QSize viewSize = viewport()->size();
+	horizontalScrollBar()->setRange(
+		0, std::max(0, _levelSize.width() - viewSize.width()));
+	horizontalScrollBar()->setPageStep(viewSize.width());
+	verticalScrollBar()->setRange(
+		0, std::max(0, _levelSize.height() - viewSize.height()));
+	verticalScrollBar()->setPageStep(viewSize.height());
+	horizontalScrollBar()->setValue(
+		qRound(fraction.x() * _levelSize.width()) - anchor.x());
+	verticalScrollBar()->setValue(
+		qRound(fraction.y() * _levelSize.height()) - anchor.y());
+	viewport()->update();
+}
+
+void MapView::paintEvent(QPaintEvent *event)
+{
+	if (!_renderer || _levelSize.isEmpty()) {
+		return;
+	}
+	const int size = MapTileCache::kTileSize;
+	const QRect map(QPoint(0, 0), _levelSize);
+	const QPoint origin = mapOrigin();
+	const QRect visible = event->rect().translated(-origin).intersected(map);
+	if (visible.isEmpty()) {
+		return;
+	}
+	const unsigned width = levelWidth();
+	QPainter p(viewport());
+	for (int row = visible.top() / size; row <= visible.bottom() / size;
+	     row++) {
+		for (int col = visible.left() / size;
+		     col <= visible.right() / size; col++) {
+			// the tiles at the right and bottom edges are cut
+			const QRect rect =
+				QRect(col * size, row * size, size, size)
+					.intersected(map);
+			const QString key = MapTileCache::key(
+				_galaxyKey, width, _fontSize, col, row);
+			const QImage tile = _cache.find(key);
+			if (tile.isNull()) {
+				p.fillRect(rect.translated(origin), Qt::black);
+				requestTile(key, rect);
+			} else {
+				p.drawImage(rect.topLeft() + origin, tile);
+			}
+		}
+	}
+	drawOverlay(p, visible, origin);
+	drawTour(p, origin);
+}
+
+void MapView::drawOverlay(QPainter &p, const QRect &visible,
+			  const QPoint &origin) const
+{
+	if (!_overlay || _overlay->counts().isEmpty()) {
+		return;
+	}
+	const unsigned width = levelWidth();
+	// a ring around the star, thicker for more rows
+	const double starR = 0.5 * _fontSize;
+	const double ringR = 2.0 * starR + 3.0;
+	const double maxCount = _overlay->maxCount();
+	const QRectF area = QRectF(visible).adjusted(-2 * ringR, -2 * ringR,
+						     2 * ringR, 2 * ringR);
+	p.setRenderHint(QPainter::Antialiasing, true);
+	p.setBrush(Qt::NoBrush);
+	for (auto it = _overlay->counts().constBegin();
+	     it != _overlay->counts().constEnd(); ++it) {
+		const MapStar *star = _renderer->star(it.key());
+		if (!star) {
+			continue;
+		}
+		const QPointF pos =
+			_renderer->imagePos(width, _fontSize, star->position);
+		if (!area.contains(pos)) {
+			continue;
+		}
+		const double weight =
+			std::log1p(double(it.value())) / std::log1p(maxCount);
+		p.setPen(QPen(QColor(255, 0, 255, 160 + 95 * weight),
+			      1.5 + 3.0 * weight));
+		p.drawEllipse(pos + origin, ringR, ringR);
+		if (it.value() > 1) {
+			p.setPen(QColor(255, 0, 255));
+			p.drawText(pos + origin + QPointF(ringR, -ringR),
+				   QString::number(it.value()));
+		}
+	}
+}
+
+void MapView::drawTour(QPainter &p, const QPoint &origin) const
+{
+	if (_tourPath.size() < 2) {
+		return;
+	}
+	const unsigned width = levelWidth();
+	auto position = [&](unsigned starId, QPointF &pos) {
+		const MapStar *star = _renderer->star(starId);
+		if (star) {
+			pos = _renderer->imagePos(width, _fontSize, star->position)
+			      + origin;
+		}
+		return star != nullptr;
+	};
+	// a few dozen legs, Qt clips what is out of sight
+	p.setRenderHint(QPainter::Antialiasing, true);
+	QPointF from;
+	bool hasFrom = position(_tourPath.front().starId, from);
+	for (size_t i = 1; i < _tourPath.size(); i++) {
+		QPointF to;
+		if (!position(_tourPath[i].starId, to)) {
+			hasFrom = false;
+			continue;
+		}
+		if (hasFrom) {
+			p.setPen(QPen(QColor(255, 200, 0, 200), 2.0,
+				      _tourPath[i].blackHole ? Qt::DashLine
+							     : Qt::SolidLine));
+			p.drawLine(from, to);
+		}
+		from = to;
+		hasFrom = true;
+	}
+	const double starR = 0.5 * _fontSize;
+	p.setPen(QColor(255, 200, 0));
+	for (size_t i = 0; i < _tourStops.size(); i++) {
+		QPointF pos;
+		if (position(_tourStops[i], pos)) {
+			p.drawText(pos + QPointF(-starR - 2.0 * _fontSize, -starR),
+				   QString::number(i + 1));
+		}
+	}
+}
+
+void MapView::resizeEvent(QResizeEvent * /*event*/)
+{
+	updateLevel(viewport()->rect().center());
+}
+
+void MapView::scrollContentsBy(int /*dx*/, int /*dy*/)
+{
+	// draws where the scrolling stops, not every tile passed by
+	cancelRequests();
+	viewport()->update();
+}
+
+void MapView::wheelEvent(QWheelEvent *event)
+{
+	if (!(event->modifiers() & Qt::ControlModifier)) {
+		QAbstractScrollArea::wheelEvent(event);
+		return;
+	}
+	// touchpads send a notch in several small steps
+	_wheelDelta += event->angleDelta().y();
+	const int steps = _wheelDelta / 120;
+	_wheelDelta -= steps * 120;
+	if (steps != 0) {
+		setZoom(_zoom + steps, event->pos());
+	}
+	event->accept();
+}
+
+void MapView::requestTile(const QString &key, const QRect &rect)
+{
+	if (_requested.contains(key)) {
+		return;
+	}
+	_requested.insert(key);
+	std::shared_ptr<const GalaxyMapRenderer> renderer = _renderer;
+	const unsigned width = levelWidth();
+	const int fontSize = _fontSize;
+	QtConcurrent::run(&_pool, [this, renderer, key, rect, width, fontSize] {
+		QImage tile = _cache.load(key);
+		if (tile.size() != rect.size()) {
+			tile = renderer->tile(width, fontSize, rect);
+			_cache.save(key, tile);
+		}
+		QMetaObject::invokeMethod(this, "tileReady",
+					  Qt::QueuedConnection,
+					  Q_ARG(QString, key),
+					  Q_ARG(QImage, tile));
+	});
+}
+
+void MapView::tileReady(const QString &key, const QImage &tile)
+{
+	_requested.remove(key);
+	_cache.insert(key, tile);
+	viewport()->update();
+}
+
+void MapView::cancelRequests()
+{
+	// the tiles being drawn still arrive and are cached
+	_pool.clear();
+	_requested.clear();
+}
@@ -0,0 +1,82 @@
+#ifndef MAPVIEW_H
+#define MAPVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QPointer>
+#include <QSet>
+#include <QThreadPool>
+#include <memory>
+
+#include "GalaxyMapRenderer.h"
+#include "MapOverlay.h"
+#include "MapTileCache.h"
+#include "RoutePlanner.h"
+
+//Shows the galaxy map as 256 px tiles. Every zoom level is the map of twice
+//the width of the one below it, the map width set by the user is zoom 0.
+//Only the visible tiles are drawn, in the background, and kept in a
+//MapTileCache; Ctrl+wheel zooms around the mouse cursor. The markers of a
+//MapOverlay and a planned tour are painted over the tiles, a changed filter
+//draws no tile.
+class MapView : public QAbstractScrollArea
+{
+	Q_OBJECT
+public:
+	static const int kMinZoom=-4;
+	static const int kMaxZoom=2;
+
+	explicit MapView(QWidget *parent=nullptr);
+	~MapView();
+	//takes a copy, the renderer stays free for the saved maps
+	void setRenderer(const GalaxyMapRenderer& renderer);
+	void setMapWidth(unsigned width);
+	void setFontSize(int fontSize);
+	//marks the stars of the overlay, null for none
+	void setOverlay(const MapOverlay* overlay);
+	//the way through path, the stops numbered in their order; empty for none
+	void setTour(const std::vector<RoutePlanner::Hop>& path, const std::vector<unsigned>& stops);
+	int zoom() const
+	{
+		return _zoom;
+	}
+	//keeps the point at anchor (viewport coordinates, the center if null) in place
+	void setZoom(int zoom, const QPoint& anchor=QPoint());
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void scrollContentsBy(int dx, int dy) override;
+	void wheelEvent(QWheelEvent *event) override;
+
+private slots:
+	void tileReady(const QString& key, const QImage& tile);
+
+private:
+	unsigned levelWidth() const;
+	//top left corner of the map in the viewport
+	QPoint mapOrigin() const;
+	//sizes the scroll bars for the current zoom level
+	void updateLevel(const QPoint& anchor);
+	void requestTile(const QString& key, const QRect& rect);
+	void drawOverlay(QPainter& p, const QRect& visible, const QPoint& origin) const;
+	void drawTour(QPainter& p, const QPoint& origin) const;
+	//drops the queued tiles, they may be out of sight by now
+	void cancelRequests();
+
+	std::shared_ptr<const GalaxyMapRenderer> _renderer;
+	QString _galaxyKey;
+	unsigned _mapWidth=700;
+	int _fontSize=8;
+	int _zoom=0;
+	QSize _levelSize;
+	QPointer<const MapOverlay> _overlay;
+	std::vector<RoutePlanner::Hop> _tourPath;
+	std::vector<unsigned> _tourStops;
+	int _wheelDelta=0;
+
+	MapTileCache _cache;
+	QThreadPool _pool;
+	QSet<QString> _requested;
+};
+
+#endif // MAPVIEW_H
@@ -0,0 +1,217 @@
+#include "MarketMatrix.h"
+#include "Galaxy.h"
+
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MARKETMATRIX_SSE2
+#endif
+
+namespace
+{
+QRgb saleColor(unsigned price, unsigned quantity, unsigned minSellPrice,
+	       unsigned maxBuyPrice)
+{
+	if (price > maxBuyPrice || quantity == 0) {
+		return 0;
+	}
+	// cheaper than anywhere is full green
+	const int range = std::max(1, int(maxBuyPrice) - int(minSellPrice));
+	const int scale =
+		255 + 255.0 * (int(minSellPrice) - int(price)) / range;
+	return qRgba(0, 163, 22, std::min(scale, 255));
+}
+
+QRgb buyColor(unsigned price, unsigned minSellPrice, unsigned maxBuyPrice)
+{
+	if (price < minSellPrice) {
+		return 0;
+	}
+	const int range = std::max(1, int(maxBuyPrice) - int(minSellPrice));
+	const int scale = 255.0 * (int(price) - int(minSellPrice)) / range;
+	return qRgba(0, 116, 224, std::min(scale, 255));
+}
+
+bool moreProfit(const MarketMatrix::Trade &a, const MarketMatrix::Trade &b)
+{
+	return a.profitPerDistance > b.profitPerDistance;
+}
+
+// keeps the count best trades at the front
+void keepBest(std::vector<MarketMatrix::Trade> &trades, unsigned count)
+{
+	if (trades.size() > count) {
+		std::partial_sort(trades.begin(), trades.begin() + count,
+				  trades.end(), moreProfit);
+		trades.resize(count);
+	}
+}
+} // namespace
+
+void MarketMatrix::clear()
+{
+	_quantity.clear();
+	_sale.clear();
+	_buy.clear();
+	_starIds.clear();
+	_saleHeat.clear();
+	_buyHeat.clear();
+}
+
+void MarketMatrix::build(const Galaxy &galaxy)
+{
+	clear();
+	const unsigned count = galaxy.marketsCount();
+	_quantity.resize(count * kGoods);
+	_sale.resize(count * kGoods);
+	_buy.resize(count * kGoods);
+	_saleHeat.resize(count * kGoods);
+	_buyHeat.resize(count * kGoods);
+	_starIds.resize(count);
+	const GoodsArr &minSell = galaxy.minSellPrice();
+	const GoodsArr &maxBuy = galaxy.maxBuyPrice();
+	for (unsigned row = 0; row < count; row++) {
+		const GoodsArr &quantity = galaxy.marketQuantity(row);
+		const GoodsArr &sale = galaxy.marketSale(row);
+		const GoodsArr &buy = galaxy.marketBuy(row);
+		_starIds[row] = galaxy.marketStarId(row);
+		for (int good = 0; good < kGoods; good++) {
+			const unsigned cell = row * kGoods + good;
+			_quantity[cell] = quantity[good];
+			_sale[cell] = sale[good];
+			_buy[cell] = buy[good];
+			_saleHeat[cell] = saleColor(sale[good], quantity[good],
+						    minSell[good], maxBuy[good]);
+			_buyHeat[cell] =
+				buyColor(buy[good], minSell[good], maxBuy[good]);
+		}
+	}
+}
+
+bool MarketMatrix::bestGood(unsigned from, unsigned to, int &good,
+			    int &profit) const
+{
+#ifdef MARKETMATRIX_SSE2
+	const __m128i *quantity =
+		reinterpret_cast<const __m128i *>(&_quantity[from * kGoods]);
+	const __m128i *sale =
+		reinterpret_cast<const __m128i *>(&_sale[from * kGoods]);
+	const __m128i *buy =
+		reinterpret_cast<const __m128i *>(&_buy[to * kGoods]);
+	const __m128i none = _mm_set1_epi32(INT_MIN);
+	__m128i profits[2];
+	for (int h = 0; h < 2; h++) {
+		// nothing to buy where the quantity is 0
+		const __m128i empty = _mm_cmpeq_epi32(
+			_mm_loadu_si128(quantity + h), _mm_setzero_si128());
+		const __m128i p = _mm_sub_epi32(_mm_loadu_si128(buy + h),
+						_mm_loadu_si128(sale + h));
+		profits[h] = _mm_or_si128(_mm_and_si128(empty, none),
+					  _mm_andnot_si128(empty, p));
+	}
+	auto max = [](__m128i a, __m128i b) {
+		const __m128i greater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(greater, a),
+				    _mm_andnot_si128(greater, b));
+	};
+	__m128i best = max(profits[0], profits[1]);
+	best = max(best, _mm_shuffle_epi32(best, 0x4E));
+	best = max(best, _mm_shuffle_epi32(best, 0xB1));
+	profit = _mm_cvtsi128_si32(best);
+	if (profit <= 0) {
+		return false;
+	}
+	const int lanes =
+		_mm_movemask_ps(_mm_castsi128_ps(
+			_mm_cmpeq_epi32(profits[0], best)))
+		| _mm_movemask_ps(_mm_castsi128_ps(
+			  _mm_cmpeq_epi32(profits[1], best)))
+			  << 4;
+	for (good = 0; !(lanes & (1 << good)); good++) {
+	}
+	return true;
+#else
+	profit = 0;
+	for (int g = 0; g < kGoods; g++) {
+		if (quantity(from, g) == 0) {
+			continue;
+		}
+		const int p = int(buy(to, g)) - int(sale(from, g));
+		if (p > profit) {
+			profit = p;
+			good = g;
+		}
+	}
+	return profit > 0;
+#endif
+}
+
+std::vector<MarketMatrix::Trade>
+MarketMatrix::bestTrades(unsigned count, const Distance &distance) const
+{
+	const unsigned markets = size();
+	// the stars with markets, the distances between them in one table
+	std::unordered_map<unsigned, int> starSlots;
+	std::vector<unsigned> stars;
+	std::vector<int> marketStar(markets);
+	for (unsigned row = 0; row < markets; row++) {
+		auto slot = starSlots.emplace(_starIds[row], stars.size());
+		if (slot.second) {
+			stars.push_back(_starIds[row]);
+		}
+		marketStar[row] = slot.first->second;
+	}
+	const int starCount = stars.size();
+	std::vector<double> distances(starCount * starCount);
+	for (int a = 0; a < starCount; a++) {
+		for (int b = 0; b < starCount; b++) {
+			distances[a * starCount + b] = distance(stars[a], stars[b]);
+		}
+	}
+
+	QVector<unsigned> rows(markets);
+	std::iota(rows.begin(), rows.end(), 0u);
+	const QVector<std::vector<Trade>> rowTrades =
+		QtConcurrent::blockingMapped<QVector<std::vector<Trade>>>(
+			rows, [&](unsigned from) {
+				std::vector<Trade> trades;
+				for (unsigned to = 0; to < markets; to++) {
+					Trade trade;
+					if (to == from
+					    || !bestGood(from, to, trade.good,
+							 trade.profit)) {
+						continue;
+					}
+					trade.fromRow = from;
+					trade.toRow = to;
+					trade.quantity = quantity(from, trade.good);
+					trade.distance =
+						distances[marketStar[from] * starCount
+							  + marketStar[to]];
+					if (std::isinf(trade.distance)) {
+						continue;
+					}
+					// markets at one star are a jump apart
+					trade.profitPerDistance =
+						trade.profit
+						/ std::max(1.0, trade.distance);
+					trades.push_back(trade);
+				}
+				keepBest(trades, count);
+				return trades;
+			});
+	std::vector<Trade> trades;
+	for (const std::vector<Trade> &t : rowTrades) {
+		trades.insert(trades.end(), t.begin(), t.end());
+	}
+	keepBest(trades, count);
+	std::sort(trades.begin(), trades.end(), moreProfit);
+	return trades;
+}
@@ -0,0 +1,83 @@
+#ifndef MARKETMATRIX_H
+#define MARKETMATRIX_H
+
+#include <QRgb>
+#include <functional>
+#include <vector>
+
+class Galaxy;
+
+//The goods of all markets packed into three M×8 arrays, row by market in the
+//order of the trade table, with the heat colours of the price cells worked
+//out once per dump. The arbitrage search runs over the rows 8 goods at a
+//time.
+class MarketMatrix
+{
+public:
+	static const int kGoods=8;
+
+	//a good bought at one market and sold at another
+	struct Trade
+	{
+		unsigned fromRow=0;
+		unsigned toRow=0;
+		int good=0;
+		int profit=0;//per unit
+		unsigned quantity=0;//on sale at fromRow
+		double distance=0.0;
+		double profitPerDistance=0.0;
+	};
+	//distance between two stars
+	using Distance=std::function<double(unsigned,unsigned)>;
+
+	void clear();
+	//reads the markets of the parsed dump
+	void build(const Galaxy& galaxy);
+	unsigned size() const
+	{
+		return _starIds.size();
+	}
+	unsigned quantity(unsigned row, int good) const
+	{
+		return _quantity[row*kGoods+good];
+	}
+	unsigned sale(unsigned row, int good) const
+	{
+		return _sale[row*kGoods+good];
+	}
+	unsigned buy(unsigned row, int good) const
+	{
+		return _buy[row*kGoods+good];
+	}
+	unsigned starId(unsigned row) const
+	{
+		return _starIds[row];
+	}
+	//0 for a cell without colour
+	QRgb saleHeat(unsigned row, int good) const
+	{
+		return _saleHeat[row*kGoods+good];
+	}
+	QRgb buyHeat(unsigned row, int good) const
+	{
+		return _buyHeat[row*kGoods+good];
+	}
+
+	//the count trades with the most profit per distance, of the best good
+	//of every pair of markets; the distances are asked on the calling
+	//thread, once for each pair of stars with markets
+	std::vector<Trade> bestTrades(unsigned count, const Distance& distance) const;
+
+private:
+	//best good of buying at from and selling at to, false without profit
+	bool bestGood(unsigned from, unsigned to, int& good, int& profit) const;
+
+	std::vector<unsigned> _quantity;
+	std::vector<unsigned> _sale;
+	std::vector<unsigned> _buy;
+	std::vector<unsigned> _starIds;
+	std::vector<QRgb> _saleHeat;
+	std::vector<QRgb> _buyHeat;
+};
+
+#endif // MARKETMATRIX_H
@@ -0,0 +1,91 @@
+#include "Pivot.h"
+#include "HashAggregate.h"
+
+#include <QAbstractItemModel>
+#include <QVariant>
+#include <algorithm>
+
+double Pivot::Cell::value(Function function) const
+{
+	switch (function) {
+	case kCount:
+		return count;
+	case kSum:
+		return sum;
+	case kAverage:
+		return count ? sum / count : 0.0;
+	case kMin:
+		return count ? min : 0.0;
+	case kMax:
+		return count ? max : 0.0;
+	}
+	return 0.0;
+}
+
+void Pivot::run(const QAbstractItemModel &model, const std::vector<int> &rows,
+		int groupCol, int acrossCol, int valueCol,
+		const QSet<int> &callerCols)
+{
+	// the columns of callerCols are copied here first, the others are read
+	// by the threads that aggregate them
+	auto copy = [&](int col) {
+		std::vector<QVariant> cells;
+		if (col >= 0 && callerCols.contains(col)) {
+			cells.reserve(rows.size());
+			for (int row : rows) {
+				cells.push_back(model.data(model.index(row, col)));
+			}
+		}
+		return cells;
+	};
+	const std::vector<QVariant> groupCells = copy(groupCol);
+	const std::vector<QVariant> acrossCells = copy(acrossCol);
+	const std::vector<QVariant> valueCells = copy(valueCol);
+	auto read = [&](const std::vector<QVariant> &copied, int i, int col) {
+		if (!copied.empty()) {
+			return copied[i];
+		}
+		return col < 0 ? QVariant() : model.data(model.index(rows[i], col));
+	};
+	// a cell costs more than its hash, the threads pay off sooner
+	const int minRowsPerRange = 512;
+	_cells = hashAggregate<QPair<QString, QString>, Cell>(
+		rows.size(),
+		[&](int i) {
+			return qMakePair(read(groupCells, i, groupCol).toString(),
+					 read(acrossCells, i, acrossCol).toString());
+		},
+		[&](Cell &cell, int i) {
+			cell.count++;
+			if (valueCol < 0) {
+				return;
+			}
+			const double value =
+				read(valueCells, i, valueCol).toDouble();
+			cell.sum += value;
+			cell.min = std::min(cell.min, value);
+			cell.max = std::max(cell.max, value);
+		},
+		[](Cell &cell, const Cell &later) {
+			cell.count += later.count;
+			cell.sum += later.sum;
+			cell.min = std::min(cell.min, later.min);
+			cell.max = std::max(cell.max, later.max);
+		},
+		minRowsPerRange);
+	QSet<QString> groups, across;
+	for (auto i = _cells.begin(); i != _cells.end(); ++i) {
+		groups.insert(i.key().first);
+		across.insert(i.key().second);
+	}
+	auto sorted = [](const QSet<QString> &set) {
+		QStringList list = set.toList();
+		std::sort(list.begin(), list.end(),
+			  [](const QString &a, const QString &b) {
+				  return QString::localeAwareCompare(a, b) < 0;
+			  });
+		return list;
+	};
+	_groups = sorted(groups);
+	_across = sorted(across);
+}
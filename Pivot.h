@@ -0,0 +1,57 @@
+#ifndef PIVOT_H
+#define PIVOT_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QStringList>
+#include <limits>
+#include <vector>
+
+class QAbstractItemModel;
+
+//Group-by of the rows of a table: the rows are grouped by the text of one
+//column, and of a second one across if it is given, and a numeric column is
+//counted, summed or averaged per group.
+class Pivot
+{
+public:
+	enum Function {kCount, kSum, kAverage, kMin, kMax};
+	struct Cell
+	{
+		int count=0;
+		double sum=0.0;
+		double min=std::numeric_limits<double>::infinity();
+		double max=-std::numeric_limits<double>::infinity();
+		double value(Function function) const;
+	};
+
+	//rows are rows of the model, acrossCol and valueCol are -1 if not used;
+	//the cells are read in chunks of rows by the pool threads, those of
+	//callerCols only in the calling thread, like the Dist. and Route columns
+	//that fill caches of the galaxy
+	void run(const QAbstractItemModel& model, const std::vector<int>& rows,
+		 int groupCol, int acrossCol, int valueCol,
+		 const QSet<int>& callerCols=QSet<int>());
+	//sorted
+	const QStringList& groups() const
+	{
+		return _groups;
+	}
+	const QStringList& across() const
+	{
+		return _across;
+	}
+	//count 0 if the group has no rows
+	Cell cell(const QString& group, const QString& across) const
+	{
+		return _cells.value(qMakePair(group,across));
+	}
+
+private:
+	QHash<QPair<QString,QString>,Cell> _cells;
+	QStringList _groups;
+	QStringList _across;
+};
+
+#endif // PIVOT_H
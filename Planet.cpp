@@ -89,15 +89,21 @@ Planet::Planet(QTextStream &stream, Galaxy &galaxy, unsigned id, unsigned starId
 			break;
 
 		case 9://ShopGoods
-			_goodsShopQuantity=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsShopQuantity=GoodsArr(value);
+			}
 			break;
 
 		case 10://ShopGoodsSale
-			_goodsSale=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsSale=GoodsArr(value);
+			}
 			break;
 
 		case 11://ShopGoodsBuy
-			_goodsBuy=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsBuy=GoodsArr(value);
+			}
 			break;
 
 		case 12://WaterSpace
@@ -157,7 +163,9 @@ Planet::Planet(QTextStream &stream, Galaxy &galaxy, unsigned id, unsigned starId
 			break;
 
 		case 22://TechLevels ^{
-			readTechLevels(value);
+			if(galaxy.projection().has(ParseProjection::kPlanetTechLevels)) {
+				readTechLevels(value);
+			}
 			break;
 		case 23://CurrentInvention ^{
 			_currentInvention=value.toUInt();
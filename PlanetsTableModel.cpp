@@ -1,5 +1,5 @@
 #include "PlanetsTableModel.h"
-#include "FilterHorizontalHeaderView.h"
+#include "SortMultiFilterProxyModel.h"
 
 PlanetsTableModel::PlanetsTableModel(const Galaxy *galaxy, QObject *parent):
     QAbstractTableModel(parent),_galaxy(galaxy)
@@ -14,7 +14,7 @@ int PlanetsTableModel::rowCount(const QModelIndex &parent) const
 
 int PlanetsTableModel::columnCount(const QModelIndex &parent) const
 {
-    return 32;
+    return 33;
 }
 QVariant PlanetsTableModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
@@ -28,7 +28,7 @@ QVariant PlanetsTableModel::headerData(int section, Qt::Orientation orientation,
 					  tr("TL9"), tr("TL10"),tr("TL11"),
 					  tr("TL12"), tr("TL13"),tr("TL14"),
 					  tr("TL15"), tr("TL16"),tr("TL17"),
-					  tr("TL18"), tr("TL19")};
+					  tr("TL18"), tr("TL19"),tr("Route")};
     if (role == Qt::DisplayRole)
     {
 	if (orientation == Qt::Vertical)
@@ -41,29 +41,44 @@ QVariant PlanetsTableModel::headerData(int section, Qt::Orientation orientation,
     }
     if(orientation==Qt::Horizontal && role==Qt::UserRole)
     {
-	if (section==2) {
-	    return FilterHorizontalHeaderView::wtInt;
+	if (section==kDistColumn || section==kRouteColumn) {
+	    return SortMultiFilterProxyModel::ctInt;
 	}
 	else if(section<5) {
-	    return FilterHorizontalHeaderView::wtString;
+	    return SortMultiFilterProxyModel::ctString;
 	}
 	else if(section==10) {
-	    return FilterHorizontalHeaderView::wtDouble;
+	    return SortMultiFilterProxyModel::ctDouble;
 	}
 	else if (section<7 || section>8) {
-	    return FilterHorizontalHeaderView::wtInt;
+	    return SortMultiFilterProxyModel::ctInt;
 	}
-	return FilterHorizontalHeaderView::wtString;
+	return SortMultiFilterProxyModel::ctString;
     }
     return QVariant();
 }
 QVariant PlanetsTableModel::data(const QModelIndex &index, int role) const
 {
+    if (role == RowFilter::StarIdRole)
+    {
+	return _galaxy->planetStarId(index.row());
+    }
+    if (role == Qt::BackgroundRole && _diff)
+    {
+	if (_diff->planetChanged(_galaxy->planet(index.row()).id())) {
+	    return QColor(255,240,170);
+	}
+	return QVariant();
+    }
+    if (role == Qt::ToolTipRole && index.column()==kRouteColumn)
+    {
+	return _galaxy->routeText(_galaxy->referenceStarId(_referenceStar),_galaxy->planetStarId(index.row()));
+    }
     if (role == Qt::DisplayRole)
     {
 	int col=index.column();
 	int row=index.row();
-	if(_galaxy->planet(row).owner()=="None" && col>2) {
+	if(_galaxy->planet(row).owner()=="None" && col>kDistColumn && col!=kRouteColumn) {
 	    return "-";
 	}
 	switch (col)
@@ -72,8 +87,8 @@ QVariant PlanetsTableModel::data(const QModelIndex &index, int role) const
 	    return _galaxy->planet(row).name();
 	case 1:
 	    return _galaxy->planetStarName(row);
-	case 2:
-	    return std::round(_galaxy->planetDistance(row));
+	case kDistColumn:
+	    return std::round(_galaxy->planetDistance(row,_galaxy->referenceStarId(_referenceStar)));
 	case 3:
 	    return _galaxy->planetOwner(row);
 	case 4:
@@ -92,6 +107,8 @@ QVariant PlanetsTableModel::data(const QModelIndex &index, int role) const
 	    return std::round(_galaxy->planet(row).currentInvetionPoints()*1000.0)*0.001;
 	case 11:
 	    return _galaxy->planet(row).relation();
+	case kRouteColumn:
+	    return std::round(_galaxy->routeDistance(_galaxy->referenceStarId(_referenceStar),_galaxy->planetStarId(row)));
 	default:
 	    return _galaxy->planet(row).techLevel(col-12);
 	}
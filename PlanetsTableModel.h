@@ -4,16 +4,33 @@
 #include <QAbstractTableModel>
 
 #include "Galaxy.h"
+#include "DumpDiff.h"
 
 class PlanetsTableModel : public QAbstractTableModel
 {
     Q_OBJECT
 public:
+    //columns measured from the reference star, also read by the presets
+    enum {kDistColumn=2, kRouteColumn=32};
     explicit PlanetsTableModel(const Galaxy* galaxy, QObject *parent = 0);
     int rowCount(const QModelIndex &parent = QModelIndex()) const ;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    //Dist. and Route of the planets from this star, -1 for the star of the player
+    void setReferenceStar(int starId)
+    {
+        _referenceStar=starId;
+        if(rowCount()>0) {
+            emit dataChanged(index(0,kDistColumn),index(rowCount()-1,kDistColumn));
+            emit dataChanged(index(0,kRouteColumn),index(rowCount()-1,kRouteColumn));
+        }
+    }
+    //planets with another owner or tech level than in the last dump are highlighted
+    void setDiff(const DumpDiff* diff)
+    {
+        _diff=diff;
+    }
     void reload()
     {
         beginResetModel();
@@ -21,6 +38,8 @@ public:
     }
 private:
     const Galaxy *_galaxy;
+    int _referenceStar=-1;
+    const DumpDiff* _diff=nullptr;
 };
 
 #endif // PLANETSTABLEMODEL_H
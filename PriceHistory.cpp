@@ -0,0 +1,287 @@
+#include "PriceHistory.h"
+#include "DumpDiff.h"
+#include "Galaxy.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <algorithm>
+
+namespace
+{
+const char kMagic[] = "SRPH";
+const char kVersion = 1;
+
+void putVarint(QByteArray &out, quint64 value)
+{
+	while (value >= 0x80) {
+		out.append(char(value | 0x80));
+		value >>= 7;
+	}
+	out.append(char(value));
+}
+
+bool getVarint(const char *&p, const char *end, quint64 &value)
+{
+	value = 0;
+	for (int shift = 0; p != end && shift < 64; shift += 7) {
+		const unsigned char byte = *p++;
+		value |= quint64(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+quint64 zigzag(qint64 value)
+{
+	return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+qint64 unzigzag(quint64 value)
+{
+	return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+unsigned cell(const MarketMatrix &markets, unsigned row, int column)
+{
+	const int good = column % PriceHistory::kGoods;
+	switch (column / PriceHistory::kGoods) {
+	case PriceHistory::kQuantity:
+		return markets.quantity(row, good);
+	case PriceHistory::kSale:
+		return markets.sale(row, good);
+	default:
+		return markets.buy(row, good);
+	}
+}
+} // namespace
+
+QString PriceHistory::fileName(const Galaxy &galaxy)
+{
+	std::vector<unsigned> stars = galaxy.starIndex().ids();
+	std::sort(stars.begin(), stars.end());
+	QCryptographicHash hash(QCryptographicHash::Md5);
+	hash.addData(reinterpret_cast<const char *>(stars.data()),
+		     stars.size() * sizeof(unsigned));
+	return QString::fromLatin1(hash.result().toHex().left(16)) + ".srph";
+}
+
+bool PriceHistory::open(const QString &dir, const Galaxy &galaxy)
+{
+	close();
+	QDir().mkpath(dir);
+	_file.setFileName(QDir(dir).filePath(fileName(galaxy)));
+	if (!_file.open(QIODevice::ReadWrite)) {
+		return false;
+	}
+	const QByteArray data = _file.readAll();
+	if (data.isEmpty()) {
+		_file.write(kMagic, 4);
+		_file.write(&kVersion, 1);
+		return _file.flush();
+	}
+	if (!data.startsWith(kMagic) || data.size() < 5 || data[4] != kVersion) {
+		_file.close();
+		return false;
+	}
+	const char *p = data.constData() + 5;
+	const char *end = data.constData() + data.size();
+	const char *good = p;
+	quint64 length;
+	while (p != end && getVarint(p, end, length)
+	       && length <= quint64(end - p)
+	       && decodeBlock(QByteArray::fromRawData(p, length))) {
+		p += length;
+		good = p;
+	}
+	// a block cut short by a crash is dropped, the next one replaces it
+	if (good != end) {
+		_file.resize(good - data.constData());
+	}
+	return _file.seek(_file.size());
+}
+
+void PriceHistory::close()
+{
+	_file.close();
+	_days.clear();
+	_keys.clear();
+	_slots.clear();
+	_series.clear();
+}
+
+bool PriceHistory::append(const Galaxy &galaxy)
+{
+	const unsigned day = galaxy.currentDay();
+	if (!isOpen() || day <= lastDay()) {
+		return false;
+	}
+	const MarketMatrix &markets = galaxy.marketMatrix();
+	QByteArray block;
+	putVarint(block, day - lastDay());
+
+	// slots of the markets, the new keys extend the dictionary
+	std::vector<std::pair<unsigned, unsigned>> slotRows; // slot, row
+	std::vector<quint64> newKeys;
+	for (unsigned row = 0; row < markets.size(); row++) {
+		const quint64 key = DumpDiff::marketKey(galaxy, row);
+		auto slot = _slots.find(key);
+		if (slot != _slots.end()) {
+			slotRows.emplace_back(slot->second, row);
+		} else {
+			slotRows.emplace_back(_keys.size() + newKeys.size(), row);
+			newKeys.push_back(key);
+		}
+	}
+	putVarint(block, newKeys.size());
+	for (quint64 key : newKeys) {
+		putVarint(block, key);
+	}
+	std::sort(slotRows.begin(), slotRows.end());
+	putVarint(block, slotRows.size());
+	unsigned previousSlot = 0;
+	for (const auto &slotRow : slotRows) {
+		putVarint(block, slotRow.first - previousSlot);
+		previousSlot = slotRow.first;
+	}
+	for (int column = 0; column < kFields * kGoods; column++) {
+		for (const auto &slotRow : slotRows) {
+			qint64 previous = 0;
+			if (slotRow.first < _series.size()
+			    && !_series[slotRow.first].columns[column].empty()) {
+				previous = _series[slotRow.first].columns[column].back();
+			}
+			putVarint(block,
+				  zigzag(qint64(cell(markets, slotRow.second, column))
+					 - previous));
+		}
+	}
+
+	QByteArray framed;
+	putVarint(framed, block.size());
+	framed += block;
+	if (_file.write(framed) != framed.size() || !_file.flush()) {
+		return false;
+	}
+	// the block is read back the way open() would
+	return decodeBlock(block);
+}
+
+bool PriceHistory::decodeBlock(const QByteArray &block)
+{
+	const char *p = block.constData();
+	const char *end = p + block.size();
+	quint64 dayDelta, newKeys, count;
+	if (!getVarint(p, end, dayDelta) || !getVarint(p, end, newKeys)) {
+		return false;
+	}
+	std::vector<quint64> keys(newKeys);
+	for (quint64 &key : keys) {
+		if (!getVarint(p, end, key)) {
+			return false;
+		}
+	}
+	if (!getVarint(p, end, count)) {
+		return false;
+	}
+	const size_t slotCount = _keys.size() + keys.size();
+	std::vector<unsigned> slots(count);
+	quint64 slot = 0;
+	for (unsigned &s : slots) {
+		quint64 delta;
+		if (!getVarint(p, end, delta) || (slot += delta) >= slotCount) {
+			return false;
+		}
+		s = slot;
+	}
+	std::vector<qint64> values(count * kFields * kGoods);
+	for (qint64 &value : values) {
+		quint64 encoded;
+		if (!getVarint(p, end, encoded)) {
+			return false;
+		}
+		value = unzigzag(encoded);
+	}
+
+	// the whole block is read, it can be applied
+	const unsigned day = lastDay() + dayDelta;
+	_days.push_back(day);
+	for (quint64 key : keys) {
+		_slots.emplace(key, _keys.size());
+		_keys.push_back(key);
+	}
+	_series.resize(_keys.size());
+	for (unsigned s : slots) {
+		_series[s].days.push_back(day);
+	}
+	for (int column = 0; column < kFields * kGoods; column++) {
+		for (unsigned i = 0; i < count; i++) {
+			std::vector<unsigned> &samples =
+				_series[slots[i]].columns[column];
+			const qint64 previous = samples.empty() ? 0 : samples.back();
+			samples.push_back(previous + values[column * count + i]);
+		}
+	}
+	return true;
+}
+
+const PriceHistory::Series *PriceHistory::series(quint64 marketKey) const
+{
+	auto slot = _slots.find(marketKey);
+	return slot == _slots.end() ? nullptr : &_series[slot->second];
+}
+
+std::vector<PriceHistory::Point> PriceHistory::range(quint64 marketKey,
+						     int good, Field field,
+						     unsigned fromDay,
+						     unsigned toDay) const
+{
+	std::vector<Point> points;
+	const Series *s = series(marketKey);
+	if (!s) {
+		return points;
+	}
+	const auto first =
+		std::lower_bound(s->days.begin(), s->days.end(), fromDay);
+	const auto last = std::upper_bound(first, s->days.end(), toDay);
+	const std::vector<unsigned> &column = s->columns[field * kGoods + good];
+	for (auto day = first; day != last; ++day) {
+		points.push_back({*day, column[day - s->days.begin()]});
+	}
+	return points;
+}
+
+PriceHistory::Trend PriceHistory::trend(quint64 marketKey, int good,
+					Field field, unsigned fromDay,
+					unsigned toDay) const
+{
+	Trend trend;
+	const std::vector<Point> points =
+		range(marketKey, good, field, fromDay, toDay);
+	if (points.empty()) {
+		return trend;
+	}
+	trend.samples = points.size();
+	trend.firstDay = points.front().day;
+	trend.lastDay = points.back().day;
+	trend.first = points.front().value;
+	trend.last = points.back().value;
+	trend.min = trend.max = trend.first;
+	double meanDay = 0.0, meanValue = 0.0;
+	for (const Point &point : points) {
+		trend.min = std::min(trend.min, point.value);
+		trend.max = std::max(trend.max, point.value);
+		meanDay += point.day;
+		meanValue += point.value;
+	}
+	meanDay /= points.size();
+	meanValue /= points.size();
+	double covariance = 0.0, variance = 0.0;
+	for (const Point &point : points) {
+		covariance += (point.day - meanDay) * (point.value - meanValue);
+		variance += (point.day - meanDay) * (point.day - meanDay);
+	}
+	trend.slope = variance > 0.0 ? covariance / variance : 0.0;
+	return trend;
+}
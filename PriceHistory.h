@@ -0,0 +1,89 @@
+#ifndef PRICEHISTORY_H
+#define PRICEHISTORY_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <climits>
+#include <unordered_map>
+#include <vector>
+
+class Galaxy;
+
+//Quantity, sale and buy price of the goods of every market over the dumps of
+//one game, with the day of each dump. On disk it is an append-only file of
+//one block per dump: the market keys are dictionary encoded, every column is
+//a run of zigzag varint deltas to the previous dump, so an unchanged price
+//takes a byte. In memory every market keeps one column per field and good
+//for range scans.
+class PriceHistory
+{
+public:
+	enum Field {kQuantity, kSale, kBuy};
+	static const int kFields=3;
+	static const int kGoods=8;
+
+	struct Point
+	{
+		unsigned day;
+		unsigned value;
+	};
+	struct Trend
+	{
+		unsigned samples=0;
+		unsigned firstDay=0;
+		unsigned lastDay=0;
+		unsigned first=0;
+		unsigned last=0;
+		unsigned min=0;
+		unsigned max=0;
+		double slope=0.0;//per day, least squares
+	};
+
+	//reads the history of the game of the galaxy from dir, an empty one if
+	//there is none yet; false if the file can't be opened
+	bool open(const QString& dir, const Galaxy& galaxy);
+	void close();
+	bool isOpen() const
+	{
+		return _file.isOpen();
+	}
+	//adds the markets of the galaxy if its day is later than the last one
+	//recorded, reloading a dump or going back in the list adds nothing
+	bool append(const Galaxy& galaxy);
+	unsigned dumpCount() const
+	{
+		return _days.size();
+	}
+	unsigned lastDay() const
+	{
+		return _days.empty() ? 0 : _days.back();
+	}
+
+	//the samples of a market between the days, both included
+	std::vector<Point> range(quint64 marketKey, int good, Field field,
+				 unsigned fromDay=0, unsigned toDay=UINT_MAX) const;
+	Trend trend(quint64 marketKey, int good, Field field,
+		    unsigned fromDay=0, unsigned toDay=UINT_MAX) const;
+
+	//file name of the history of the game, from its stars
+	static QString fileName(const Galaxy& galaxy);
+
+private:
+	struct Series
+	{
+		std::vector<unsigned> days;
+		std::vector<unsigned> columns[kFields*kGoods];
+	};
+	//false if the block is cut short
+	bool decodeBlock(const QByteArray& block);
+	const Series* series(quint64 marketKey) const;
+
+	QFile _file;
+	std::vector<unsigned> _days;
+	std::vector<quint64> _keys;//dictionary of the market keys
+	std::unordered_map<quint64,unsigned> _slots;//key -> index in _keys
+	std::vector<Series> _series;//by slot
+};
+
+#endif // PRICEHISTORY_H
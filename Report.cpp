@@ -0,0 +1,324 @@
+#include "Report.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QCoreApplication>
+
+#include <iostream>
+
+QString tabSeparatedValues(const QAbstractItemModel &model)
+{
+	QString buf;
+	for (int c = 0; c < model.columnCount(); c++) {
+		buf += model.headerData(c, Qt::Horizontal).toString();
+		buf += '\t';
+	}
+	buf += '\n';
+	for (int r = 0; r < model.rowCount(); r++) {
+		for (int c = 0; c < model.columnCount(); c++) {
+			buf += model.data(model.index(r, c)).toString();
+			buf += '\t';
+		}
+		buf += '\n';
+	}
+	return buf;
+}
+
+QVariantMap loadPreset(const QString &fileName, QString *error)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		if (error) {
+			*error = QCoreApplication::translate("MainWindow",
+							     "Unable to open file ")
+				 + file.errorString() + " " + file.fileName();
+		}
+		return QVariantMap();
+	}
+	QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+	if (doc.isNull()) {
+		if (error) {
+			*error = QCoreApplication::translate(
+				"MainWindow", "Unable to parse JSON file");
+		}
+		return QVariantMap();
+	}
+	return doc.toVariant().toMap();
+}
+
+QMap<QString, Scorer> readScorers(const QString &filename)
+{
+	QMap<QString, Scorer> scorers;
+	QFile scorersFile(filename);
+	if (!scorersFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return scorers;
+	}
+	QJsonDocument doc = QJsonDocument::fromJson(scorersFile.readAll());
+	if (doc.isNull()) {
+		return scorers;
+	}
+	QVariantMap scorersJson = doc.toVariant().toMap();
+	using VarMapCI = QVariantMap::const_iterator;
+	for (VarMapCI i = scorersJson.begin(); i != scorersJson.end(); ++i) {
+		scorers[i.key()].read(i.value().toMap());
+	}
+	return scorers;
+}
+
+QMap<QString, int> readMinRowsPreset(const QString &filename)
+{
+	QMap<QString, int> minRowsPreset;
+	QFile file(filename);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		return minRowsPreset;
+	}
+	QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+	if (doc.isNull()) {
+		return minRowsPreset;
+	}
+	QVariantMap minRowsJson = doc.toVariant().toMap();
+	using VarMapCI = QVariantMap::const_iterator;
+	for (VarMapCI i = minRowsJson.begin(); i != minRowsJson.end(); ++i) {
+		minRowsPreset[i.key()] = i.value().toInt();
+	}
+	return minRowsPreset;
+}
+
+bool isUseless(const QMap<QString, int> &val, const QMap<QString, int> &min)
+{
+	using MapStrIntCI = QMap<QString, int>::const_iterator;
+	for (MapStrIntCI i = min.begin(); i != min.end(); ++i) {
+		if (val.value(i.key(), 0) < i.value()) {
+			std::cerr << i.key().toStdString() << " < " << i.value()
+				  << std::endl;
+			return true;
+		}
+	}
+	return false;
+}
+
+void Scorer::read(const QVariantMap &map)
+{
+	presetNames.clear();
+	weights.clear();
+	areBoolean.clear();
+	depthPenalized.clear();
+	using VarMapCI = QVariantMap::const_iterator;
+	for (VarMapCI i = map.begin(); i != map.end(); ++i) {
+		QVariantMap score = i.value().toMap();
+		const QString &presetName = i.key();
+		double weight = score.value("weight").toDouble();
+		bool isBool = score.value("isBool").toBool();
+		bool penalize = score.value("depthPenalize").toBool();
+		addPreset(presetName, weight, isBool, penalize);
+	}
+}
+
+void Scorer::addPreset(const QString presetName, double weight, bool isBool,
+		       bool depthPenalize)
+{
+	presetNames.push_back(presetName);
+	weights.push_back(weight);
+	areBoolean.push_back(isBool);
+	depthPenalized.push_back(depthPenalize);
+}
+
+constexpr double Scorer::depthOffset;
+
+Report::Report(const Galaxy *galaxy)
+	: _galaxy(galaxy), eqModel(galaxy), planetsModel(galaxy)
+{
+	eqProxyModel.setSourceModel(&eqModel);
+	planetsProxyModel.setSourceModel(&planetsModel);
+}
+
+void Report::build()
+{
+	eqModel.reload();
+	planetsModel.reload();
+	clear();
+
+	QString bhBuf = QCoreApplication::translate("MainWindow",
+						    "Black holes: %1\n")
+				.arg(_galaxy->blackHoleCount());
+
+	QString lastSummaryEntry;
+	// planets Presets
+	QString planetsBuf;
+	for (const QString &fileName : planetsReportPresets) {
+		planetsProxyModel.setPreset(loadPreset(fileName));
+		lastSummaryEntry = QFileInfo(fileName).baseName();
+		// a preset with a limit lists fewer rows than it counts
+		const int accepted = planetsProxyModel.acceptedRows().size();
+		_reportSummary[lastSummaryEntry] = accepted;
+		lastSummaryEntry += ": " + QString::number(accepted);
+		planetsBuf += lastSummaryEntry + '\n';
+		planetsBuf += tabSeparatedValues(planetsProxyModel);
+		planetsBuf += '\n';
+	}
+
+	// eq Presets
+	QString eqBuf;
+	for (const QString &fileName : eqReportPresets) {
+		eqProxyModel.setPreset(loadPreset(fileName));
+		lastSummaryEntry = QFileInfo(fileName).baseName();
+		const std::vector<int> accepted = eqProxyModel.acceptedRows();
+		_reportSummary[lastSummaryEntry] = accepted.size();
+		QVector<int> depthList;
+		for (int sourceRow : accepted) {
+			depthList.push_back(_galaxy->equipmentDepth(sourceRow));
+		}
+		_reportDepthList[lastSummaryEntry] = depthList;
+		lastSummaryEntry += ": " + QString::number(accepted.size());
+		eqBuf += lastSummaryEntry + '\n';
+		eqBuf += tabSeparatedValues(eqProxyModel);
+		eqBuf += '\n';
+	}
+
+	_text = scoresSummary() + '\n' + planetsBuf + eqBuf + basesSummary()
+		+ '\n' + bhBuf + '\n';
+}
+
+std::vector<double> Report::rowValues(const std::vector<unsigned> &rows,
+				      const Scorer &scorer)
+{
+	eqModel.reload();
+	std::vector<double> values(rows.size(), 0.0);
+	std::vector<bool> taken(rows.size(), false);
+	double least = 1.0;
+	int leastPreset = -1;
+	for (const QString &fileName : eqReportPresets) {
+		const int iPreset =
+			scorer.presetNames.indexOf(QFileInfo(fileName).baseName());
+		if (iPreset < 0) {
+			continue;
+		}
+		if (leastPreset < 0 || scorer.weights[iPreset] < least) {
+			least = scorer.weights[iPreset];
+			leastPreset = iPreset;
+		}
+		RowFilter filter;
+		filter.setPreset(loadPreset(fileName), eqModel);
+		for (size_t i = 0; i < rows.size(); i++) {
+			if (filter.accepts(eqModel, rows[i])) {
+				values[i] += scorer.rowValue(
+					iPreset, _galaxy->equipmentDepth(rows[i]));
+				taken[i] = true;
+			}
+		}
+	}
+	for (size_t i = 0; i < rows.size(); i++) {
+		if (taken[i]) {
+			continue;
+		}
+		const int depth = _galaxy->equipmentDepth(rows[i]);
+		values[i] = leastPreset < 0 ? 1.0 / (depth + Scorer::depthOffset)
+					    : scorer.rowValue(leastPreset, depth);
+	}
+	return values;
+}
+
+QString Report::query(const QVariantMap &preset, Table table)
+{
+	if (table == kPlanets) {
+		planetsModel.reload();
+		planetsProxyModel.setPreset(preset);
+		return tabSeparatedValues(planetsProxyModel);
+	}
+	eqModel.reload();
+	eqProxyModel.setPreset(preset);
+	return tabSeparatedValues(eqProxyModel);
+}
+
+bool Report::save(const QString &fileName) const
+{
+	QFile ofile(fileName);
+	if (!ofile.open(QIODevice::WriteOnly | QIODevice::Text
+			| QIODevice::Truncate)) {
+		return false;
+	}
+	QTextStream out(&ofile);
+	out.setCodec("UTF-8");
+	out << _text;
+	return true;
+}
+
+QString Report::basesSummary() const
+{
+	// Bases, sorted by distance like the "Dist." column of the trade table
+	std::vector<unsigned> rows;
+	std::vector<double> dists(_galaxy->marketsCount());
+	for (unsigned row = 0; row < _galaxy->marketsCount(); row++) {
+		dists[row] = std::round(_galaxy->marketDistance(
+						row, _galaxy->playerStarId())
+					* 10.0)
+			     / 10.0;
+		if (_galaxy->marketPlanetSize(row) == 0) { // Base, not planet
+			rows.push_back(row);
+		}
+	}
+	std::stable_sort(rows.begin(), rows.end(),
+			 [&dists](unsigned a, unsigned b) {
+				 return dists[a] < dists[b];
+			 });
+	QString basesBuf = "Bases:\nname\tstar\tdistance\n";
+	for (unsigned row : rows) {
+		basesBuf += _galaxy->marketName(row) + '\t'
+			    + _galaxy->marketStarName(row) + '\t'
+			    + QString::number(qRound(dists[row]));
+		basesBuf += '\n';
+	}
+	return basesBuf;
+}
+
+QString Report::scoresSummary(bool desc) const
+{
+	QString summary;
+	using MapStrScorerCI = QMap<QString, Scorer>::const_iterator;
+	for (MapStrScorerCI i = _scorers.begin(); i != _scorers.end(); ++i) {
+		if (desc) {
+			summary += i.key() + " = ";
+		}
+		summary += QString::number(i.value().score(_reportSummary,
+							   _reportDepthList))
+			   + "\t";
+	}
+	return summary;
+}
+
+QString Report::scoresSummaryHeader() const
+{
+	QString summary;
+	using MapStrScorerCI = QMap<QString, Scorer>::const_iterator;
+	for (MapStrScorerCI i = _scorers.begin(); i != _scorers.end(); ++i) {
+		summary += i.key() + "\t";
+	}
+	return summary;
+}
+
+QString Report::reportSummary(bool desc) const
+{
+	QString summary = scoresSummary(desc);
+	using MapStrIntCI = QMap<QString, int>::const_iterator;
+	for (MapStrIntCI i = _reportSummary.begin(); i != _reportSummary.end();
+	     ++i) {
+		if (desc) {
+			summary += i.key() + ": ";
+		}
+		summary += QString::number(i.value()) + "\t";
+	}
+	return summary;
+}
+
+QString Report::reportSummaryHeader() const
+{
+	QString summary = "dump name\t" + scoresSummaryHeader();
+	using MapStrIntCI = QMap<QString, int>::const_iterator;
+	for (MapStrIntCI i = _reportSummary.begin(); i != _reportSummary.end();
+	     ++i) {
+		summary += i.key() + "\t";
+	}
+	return summary;
+}
@@ -0,0 +1,144 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QVector>
+#include <QVariantMap>
+#include <QAbstractItemModel>
+#include <algorithm>
+#include <vector>
+
+#include "Galaxy.h"
+#include "EquipmentTableModel.h"
+#include "PlanetsTableModel.h"
+#include "SortMultiFilterProxyModel.h"
+
+struct Scorer
+{
+	void read(const QVariantMap& map);
+	void addPreset(const QString presetName,double weight,bool isBool,bool depthPenalize);
+	double score(const QMap<QString,int>& reportSummary,const QMap<QString,QVector<int>>& _reportDepthList) const
+	{
+		double score=0.0;
+		for(int iPreset=0; iPreset<presetNames.size(); iPreset++)
+		{
+			double numRows=reportSummary.value(presetNames[iPreset]);
+			if(numRows==0.0) {continue;}
+			numRows=areBoolean[iPreset]?std::min(numRows,1.0):numRows;
+			if(depthPenalized[iPreset]) {
+				auto depthList=_reportDepthList.value(presetNames[iPreset]);
+				if(areBoolean[iPreset]) {
+					int minDepth=*std::min_element(depthList.constBegin(), depthList.constEnd());
+					minDepth+=depthOffset;
+					score+=1.0*weights[iPreset]/minDepth;
+				} else {
+					for(int depth: depthList) {
+						depth+=depthOffset;
+						score+=1.0*weights[iPreset]/depth;
+					}
+				}
+			} else {
+				score+=numRows*weights[iPreset];
+			}
+		}
+		return score;
+	}
+
+	//worth of one row of the preset at the depth, as counted by score()
+	double rowValue(int iPreset, int depth) const
+	{
+		return depthPenalized[iPreset] ? weights[iPreset]/(depth+depthOffset) : weights[iPreset];
+	}
+
+	static constexpr double depthOffset=100;
+	QVector<QString> presetNames;
+	QVector<double> weights;
+	QVector<bool> areBoolean;
+	QVector<bool> depthPenalized;
+};
+
+QString tabSeparatedValues(const QAbstractItemModel &model);
+QVariantMap loadPreset(const QString &fileName, QString *error=nullptr);
+QMap<QString,Scorer> readScorers(const QString &filename);
+QMap<QString,int> readMinRowsPreset(const QString &filename);
+bool isUseless(const QMap<QString, int> &val, const QMap<QString, int> &min);
+
+//Runs the report presets against a galaxy and keeps the summary used for scoring.
+//Has no widgets, so it is shared by the GUI and the command line tool.
+class Report
+{
+public:
+	enum Table {kEquipment, kPlanets};
+	explicit Report(const Galaxy *galaxy);
+	void setPresets(const QStringList &planetsPresets, const QStringList &eqPresets)
+	{
+		planetsReportPresets=planetsPresets;
+		eqReportPresets=eqPresets;
+	}
+	void setScorers(const QMap<QString,Scorer> &scorers)
+	{
+		_scorers=scorers;
+	}
+	const QMap<QString,Scorer>& scorers() const
+	{
+		return _scorers;
+	}
+	//applies every report preset, fills summary(), depthList() and text()
+	void build();
+	//tab separated rows of one table filtered by the preset
+	QString query(const QVariantMap &preset, Table table);
+	//worth of equipment rows to the scorer, summed over the report presets
+	//that take them; a row none takes is worth the least of the presets
+	std::vector<double> rowValues(const std::vector<unsigned> &rows, const Scorer &scorer);
+
+	//writes text() as UTF-8
+	bool save(const QString &fileName) const;
+	const QString& text() const
+	{
+		return _text;
+	}
+	const QMap<QString,int>& summary() const
+	{
+		return _reportSummary;
+	}
+	const QMap<QString,QVector<int>>& depthList() const
+	{
+		return _reportDepthList;
+	}
+	//takes the summary from a StreamingScorer, for the scores without build()
+	void setSummary(const QMap<QString,int> &summary, const QMap<QString,QVector<int>> &depthList)
+	{
+		_reportSummary=summary;
+		_reportDepthList=depthList;
+	}
+	void clear()
+	{
+		_reportSummary.clear();
+		_reportDepthList.clear();
+		_text.clear();
+	}
+	QString scoresSummary(bool desc=true) const;
+	QString scoresSummaryHeader() const;
+	QString reportSummary(bool desc=true) const;
+	QString reportSummaryHeader() const;
+
+private:
+	QString basesSummary() const;
+
+	const Galaxy *_galaxy;
+	EquipmentTableModel eqModel;
+	SortMultiFilterProxyModel eqProxyModel;
+	PlanetsTableModel planetsModel;
+	SortMultiFilterProxyModel planetsProxyModel;
+
+	QStringList planetsReportPresets;
+	QStringList eqReportPresets;
+	QMap<QString,Scorer> _scorers;
+	QMap<QString,int> _reportSummary;
+	QMap<QString,QVector<int>> _reportDepthList;
+	QString _text;
+};
+
+#endif // REPORT_H
@@ -0,0 +1,146 @@
+#include "RoutePlanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void RoutePlanner::setOptions(const Options &options)
+{
+	if (options == _options) {
+		return;
+	}
+	_options = options;
+	_tables.clear();
+}
+
+void RoutePlanner::clear()
+{
+	_ids.clear();
+	_x.clear();
+	_y.clear();
+	_slots.clear();
+	_holes.clear();
+	_tables.clear();
+}
+
+void RoutePlanner::build(const StarIndex &index,
+			 const std::vector<BlackHole> &blackHoles)
+{
+	clear();
+	_ids = index.ids();
+	const int count = _ids.size();
+	_x.resize(count);
+	_y.resize(count);
+	for (int s = 0; s < count; s++) {
+		const QPointF position = index.position(_ids[s]);
+		_x[s] = position.x();
+		_y[s] = position.y();
+		_slots[_ids[s]] = s;
+	}
+	_holes.resize(count);
+	for (const BlackHole &bh : blackHoles) {
+		auto star1 = _slots.find(bh.star1Id());
+		auto star2 = _slots.find(bh.star2Id());
+		if (star1 == _slots.end() || star2 == _slots.end()) {
+			continue;
+		}
+		// a hole can be entered from either of its stars
+		_holes[star1->second].push_back(
+			{star2->second, bh.turnsToClose()});
+		_holes[star2->second].push_back(
+			{star1->second, bh.turnsToClose()});
+	}
+}
+
+bool RoutePlanner::isOpen(const Hole &hole, double travelled) const
+{
+	if (hole.turnsToClose < 1 || _options.speed <= 0.0) {
+		return true;
+	}
+	return std::ceil(travelled / _options.speed) <= hole.turnsToClose;
+}
+
+const RoutePlanner::Table &RoutePlanner::table(int source) const
+{
+	auto it = _tables.find(source);
+	if (it != _tables.end()) {
+		return it->second;
+	}
+	// a few sources are asked for at a time
+	if (_tables.size() >= 16) {
+		_tables.clear();
+	}
+	Table &t = _tables[source];
+	const int count = _ids.size();
+	const double inf = std::numeric_limits<double>::infinity();
+	t.distance.assign(count, inf);
+	t.previous.assign(count, -1);
+	t.blackHole.assign(count, 0);
+	std::vector<char> done(count, 0);
+	t.distance[source] = 0.0;
+	// every star is a jump away from every other, a heap would not pay off
+	for (;;) {
+		int u = -1;
+		for (int s = 0; s < count; s++) {
+			if (!done[s] && t.distance[s] < inf
+			    && (u < 0 || t.distance[s] < t.distance[u])) {
+				u = s;
+			}
+		}
+		if (u < 0) {
+			break;
+		}
+		done[u] = 1;
+		const double travelled = t.distance[u];
+		for (int v = 0; v < count; v++) {
+			if (done[v]) {
+				continue;
+			}
+			const double dx = _x[v] - _x[u];
+			const double dy = _y[v] - _y[u];
+			const double jump = std::sqrt(dx * dx + dy * dy);
+			if (_options.jumpRange > 0.0 && jump > _options.jumpRange) {
+				continue;
+			}
+			if (travelled + jump < t.distance[v]) {
+				t.distance[v] = travelled + jump;
+				t.previous[v] = u;
+				t.blackHole[v] = 0;
+			}
+		}
+		// arriving earlier never closes a hole, so the first arrival
+		// is the one to check
+		for (const Hole &hole : _holes[u]) {
+			const int v = hole.otherSlot;
+			if (!done[v] && isOpen(hole, travelled)
+			    && travelled < t.distance[v]) {
+				t.distance[v] = travelled;
+				t.previous[v] = u;
+				t.blackHole[v] = 1;
+			}
+		}
+	}
+	return t;
+}
+
+double RoutePlanner::distance(unsigned fromStarId, unsigned toStarId) const
+{
+	return table(slot(fromStarId)).distance[slot(toStarId)];
+}
+
+std::vector<RoutePlanner::Hop> RoutePlanner::route(unsigned fromStarId,
+						   unsigned toStarId) const
+{
+	const int source = slot(fromStarId);
+	const Table &t = table(source);
+	std::vector<Hop> hops;
+	int s = slot(toStarId);
+	if (std::isinf(t.distance[s])) {
+		return hops;
+	}
+	for (; s >= 0; s = t.previous[s]) {
+		hops.push_back({_ids[s], bool(t.blackHole[s])});
+	}
+	std::reverse(hops.begin(), hops.end());
+	return hops;
+}
@@ -0,0 +1,81 @@
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+#include "BlackHole.h"
+#include "StarIndex.h"
+#include <unordered_map>
+#include <vector>
+
+//Shortest travel between the stars. A hyperjump goes straight to any star
+//within the jump range, a black hole takes the ship to its other star at no
+//distance, if the ship gets there before the hole closes. The travel from
+//one star to all the others is found with Dijkstra over the dense graph, a
+//galaxy has a few dozen stars, and kept per source like the distances of
+//StarIndex. Not thread-safe.
+class RoutePlanner
+{
+public:
+	struct Options
+	{
+		double jumpRange=0.0;//0 for any distance
+		double speed=7.0;//distance per day, 0 if the holes never close on the way
+		bool operator==(const Options& other) const
+		{
+			return jumpRange==other.jumpRange && speed==other.speed;
+		}
+	};
+	//a star on a route
+	struct Hop
+	{
+		unsigned starId=0;
+		bool blackHole=false;//reached through a black hole
+	};
+
+	void setOptions(const Options& options);
+	const Options& options() const
+	{
+		return _options;
+	}
+	void clear();
+	//the stars of the index with the holes between them, call once both are parsed
+	void build(const StarIndex& index, const std::vector<BlackHole>& blackHoles);
+	bool isBuilt() const
+	{
+		return !_ids.empty();
+	}
+
+	//distance travelled by hyperjumps, infinity if the star can't be reached
+	double distance(unsigned fromStarId, unsigned toStarId) const;
+	//from the first star to the last, empty if there is no route
+	std::vector<Hop> route(unsigned fromStarId, unsigned toStarId) const;
+
+private:
+	struct Hole
+	{
+		int otherSlot;
+		int turnsToClose;//less than 1 if it is not closing
+	};
+	struct Table
+	{
+		std::vector<double> distance;//by slot
+		std::vector<int> previous;//slot, -1 for the source and the unreachable
+		std::vector<char> blackHole;//the slot was reached through a hole
+	};
+	int slot(unsigned id) const
+	{
+		return _slots.at(id);
+	}
+	bool isOpen(const Hole& hole, double travelled) const;
+	const Table& table(int source) const;
+
+	Options _options;
+	std::vector<unsigned> _ids;
+	std::vector<double> _x;
+	std::vector<double> _y;
+	std::unordered_map<unsigned,int> _slots;
+	std::vector<std::vector<Hole>> _holes;//by slot
+
+	mutable std::unordered_map<int,Table> _tables;//by source slot
+};
+
+#endif // ROUTEPLANNER_H
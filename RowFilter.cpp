@@ -0,0 +1,264 @@
+#include "RowFilter.h"
+
+bool RowFilter::setMin(int col, double min)
+{
+	if(min==_min[col]) {
+		return false;
+	}
+	_min[col]=min;
+	correctMinMax(col);
+	return true;
+}
+
+bool RowFilter::unsetMin(int col)
+{
+	return _min.erase(col)>0;
+}
+
+bool RowFilter::setMax(int col, double max)
+{
+	if(_max[col]==max) {
+		return false;
+	}
+	_max[col]=max;
+	correctMinMax(col);
+	return true;
+}
+
+bool RowFilter::unsetMax(int col)
+{
+	return _max.erase(col)>0;
+}
+
+bool RowFilter::setMatch(int col, const QString &match)
+{
+	if (match.isEmpty()) {
+		return unsetMatch(col);
+	}
+	if(_match.count(col) && _match.at(col).re.pattern()==match) {
+		return false;
+	}
+	_match[col]=pattern(match);
+	return true;
+}
+
+bool RowFilter::unsetMatch(int col)
+{
+	return _match.erase(col)>0;
+}
+
+bool RowFilter::setNotMatch(int col, const QString &notMatch)
+{
+	if (notMatch.isEmpty()) {
+		return unsetNotMatch(col);
+	}
+	if(_notMatch.count(col) && _notMatch.at(col).re.pattern()==notMatch) {
+		return false;
+	}
+	_notMatch[col]=pattern(notMatch);
+	return true;
+}
+
+bool RowFilter::unsetNotMatch(int col)
+{
+	return _notMatch.erase(col)>0;
+}
+
+bool RowFilter::setStars(const QSet<unsigned> &stars)
+{
+	if(_filterStars && _stars==stars) {
+		return false;
+	}
+	_filterStars=true;
+	_stars=stars;
+	return true;
+}
+
+bool RowFilter::unsetStars()
+{
+	if(!_filterStars) {
+		return false;
+	}
+	_filterStars=false;
+	_stars.clear();
+	return true;
+}
+
+void RowFilter::setFilters(const QMap<int, QString> &match, const QMap<int, QString> &notMatch, const QMap<int, double> &min, const QMap<int, double> &max)
+{
+	_match.clear();
+	_notMatch.clear();
+	_min.clear();
+	_max.clear();
+	using MapIntStrCI=QMap<int, QString>::const_iterator;
+	for (MapIntStrCI i = match.begin(); i != match.end(); ++i)
+	{
+		_match[i.key()]=pattern(i.value());
+	}
+	for (MapIntStrCI i = notMatch.begin(); i != notMatch.end(); ++i)
+	{
+		_notMatch[i.key()]=pattern(i.value());
+	}
+
+	using MapIntDoubleCI=QMap<int, double>::const_iterator;
+	for (MapIntDoubleCI i = min.begin(); i != min.end(); ++i)
+	{
+		_min[i.key()]=i.value();
+	}
+	for (MapIntDoubleCI i = max.begin(); i != max.end(); ++i)
+	{
+		if(i.value()>=_min[i.key()]) {
+			_max[i.key()]=i.value();
+		}
+	}
+}
+
+void RowFilter::setPreset(const QVariantMap &p, const QAbstractItemModel &model)
+{
+	QVariantMap matchFilters=p["match"].toMap();
+	QVariantMap notMatchFilters=p["notMatch"].toMap();
+	QVariantMap minInts=p["minInt"].toMap();
+	QVariantMap maxInts=p["maxInt"].toMap();
+	QVariantMap minDoubles=p["minDouble"].toMap();
+	QVariantMap maxDoubles=p["maxDouble"].toMap();
+
+	QMap<int,QString> match, notMatch;
+	QMap<int,double> min, max;
+	for(int col=0; col<model.columnCount(); col++)
+	{
+		const QString key=QString::number(col);
+		switch(model.headerData(col,Qt::Horizontal,Qt::UserRole).toInt())
+		{
+		case ctString:
+			if(!matchFilters.value(key).toString().isEmpty()) {
+				match[col]=matchFilters.value(key).toString();
+			}
+			if(!notMatchFilters.value(key).toString().isEmpty()) {
+				notMatch[col]=notMatchFilters.value(key).toString();
+			}
+			break;
+		case ctInt:
+			if(minInts.value(key).toInt()>0) {
+				min[col]=minInts.value(key).toInt();
+			}
+			if(maxInts.value(key).toInt()>0) {
+				max[col]=maxInts.value(key).toInt();
+			}
+			break;
+		case ctDouble:
+			if(minDoubles.value(key).toDouble()>0.0) {
+				min[col]=minDoubles.value(key).toDouble();
+			}
+			if(maxDoubles.value(key).toDouble()>0.0) {
+				max[col]=maxDoubles.value(key).toDouble();
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	setFilters(match,notMatch,min,max);
+}
+
+bool RowFilter::accepts(const QAbstractItemModel &model, int row, const QModelIndex &parent, const QSet<int> &answered) const
+{
+	if(_filterStars && !_stars.contains(model.data(model.index(row, 0, parent), StarIdRole).toUInt())) {
+		return false;
+	}
+	for(const auto& pair:_min)
+	{
+		double cellValue=model.data(model.index(row, pair.first, parent)).toDouble();
+		if(cellValue<pair.second) {
+			return false;
+		}
+	}
+	for(const auto& pair:_max)
+	{
+		double cellValue=model.data(model.index(row, pair.first, parent)).toDouble();
+		if(cellValue>pair.second) {
+			return false;
+		}
+	}
+	for(const auto& pair:_match)
+	{
+		if(answered.contains(pair.first)) {
+			continue;
+		}
+		const QString& cellValue=model.data(model.index(row, pair.first, parent)).toString();
+		if(!pair.second.isIn(cellValue)) {
+			return false;
+		}
+	}
+	for(const auto& pair:_notMatch)
+	{
+		if(answered.contains(pair.first)) {
+			continue;
+		}
+		const QString& cellValue=model.data(model.index(row, pair.first, parent)).toString();
+		if(pair.second.isIn(cellValue)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+QSet<int> RowFilter::columns() const
+{
+	QSet<int> cols;
+	for(const auto& pair:_min) {
+		cols.insert(pair.first);
+	}
+	for(const auto& pair:_max) {
+		cols.insert(pair.first);
+	}
+	for(const auto& pair:_match) {
+		cols.insert(pair.first);
+	}
+	for(const auto& pair:_notMatch) {
+		cols.insert(pair.first);
+	}
+	return cols;
+}
+
+bool RowFilter::literals(const QRegularExpression &re, QStringList &literals)
+{
+	static const QString special=QStringLiteral("^$.*+?()[]{}\\");
+	const QString pattern=re.pattern();
+	literals.clear();
+	QString literal;
+	for(int i=0; i<pattern.size(); i++)
+	{
+		const QChar c=pattern[i];
+		if(c=='|') {
+			literals<<literal;
+			literal.clear();
+		}
+		else if(c=='\\' && i+1<pattern.size() && special.contains(pattern[i+1])) {
+			literal+=pattern[++i];
+		}
+		else if(special.contains(c)) {
+			literals.clear();
+			return false;
+		}
+		else {
+			literal+=c;
+		}
+	}
+	literals<<literal;
+	if(re.patternOptions() & QRegularExpression::CaseInsensitiveOption) {
+		for(QString& l:literals) {
+			l=l.toLower();
+		}
+	}
+	return true;
+}
+
+RowFilter::Pattern RowFilter::pattern(const QString &source) const
+{
+	Pattern p;
+	p.re=QRegularExpression(source,_caseSensitive);
+	if(!p.literals.set(p.re)) {
+		p.re.optimize();
+	}
+	return p;
+}
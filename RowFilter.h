@@ -0,0 +1,120 @@
+#ifndef ROWFILTER_H
+#define ROWFILTER_H
+
+#include <unordered_map>
+
+#include <QAbstractItemModel>
+#include <QMap>
+#include <QSet>
+#include <QRegularExpression>
+#include <QString>
+#include <QVariantMap>
+
+#include "LiteralSearch.h"
+
+//Column filters of a table: min/max for numbers, match/notMatch regular
+//expressions for text. Checks single rows of a model, so the same filter
+//serves the proxy and the scoring that runs while a dump is parsed.
+class RowFilter
+{
+public:
+	//type of the filter a column supports, reported by the source models in headerData(Qt::UserRole)
+	enum ColumnType {ctString, ctInt, ctDouble, ctNone};
+	//data role of the id of the star of a row, for setStars(); Qt::UserRole
+	//and +1 are taken by HierarchicalHeaderView
+	enum {StarIdRole=Qt::UserRole+2,
+	      //depth of the treasure of an equipment row, 0 if it isn't buried
+	      DepthRole=Qt::UserRole+3};
+
+	//the setters return false if nothing changed
+	bool setMin(int col, double min);
+	bool unsetMin(int col);
+	bool setMax(int col, double max);
+	bool unsetMax(int col);
+	bool setMatch(int col, const QString& match);
+	bool unsetMatch(int col);
+	bool setNotMatch(int col, const QString& notMatch);
+	bool unsetNotMatch(int col);
+	void setFilters(const QMap<int,QString>& match,
+			const QMap<int,QString>& notMatch,
+			const QMap<int,double>& min,
+			const QMap<int,double>& max);
+	//keeps only the rows at one of the stars
+	bool setStars(const QSet<unsigned>& stars);
+	bool unsetStars();
+	//reads a *.dr.json preset, column types are taken from the model header
+	void setPreset(const QVariantMap& p, const QAbstractItemModel& model);
+
+	//the match and notMatch filters of the answered columns are taken as
+	//passed, an index has checked them
+	bool accepts(const QAbstractItemModel& model, int row,
+		     const QModelIndex& parent=QModelIndex(),
+		     const QSet<int>& answered=QSet<int>()) const;
+	//columns read by accepts()
+	QSet<int> columns() const;
+	//the filters of a column, nullptr or false if it has none
+	const QRegularExpression* match(int col) const
+	{
+		auto i=_match.find(col);
+		return i==_match.end() ? nullptr : &i->second.re;
+	}
+	const QRegularExpression* notMatch(int col) const
+	{
+		auto i=_notMatch.find(col);
+		return i==_notMatch.end() ? nullptr : &i->second.re;
+	}
+	bool min(int col, double& min) const
+	{
+		auto i=_min.find(col);
+		if(i==_min.end()) {
+			return false;
+		}
+		min=i->second;
+		return true;
+	}
+	bool max(int col, double& max) const
+	{
+		auto i=_max.find(col);
+		if(i==_max.end()) {
+			return false;
+		}
+		max=i->second;
+		return true;
+	}
+	//the literal strings of a pattern like "Fei|Gaal", lowered if the
+	//matching ignores case; false if it uses any other regex syntax
+	static bool literals(const QRegularExpression& re, QStringList& literals);
+private:
+	void correctMinMax(int col)
+	{
+		if (_min[col]>_max[col] /*|| _max[col]==0.0*/)
+		{
+			if(_max.count(col)==0) {
+				return;
+			}
+			_max.erase(col);
+		}
+	}
+	//a match or notMatch filter, searched for without PCRE if it is made of
+	//literals
+	struct Pattern
+	{
+		QRegularExpression re;
+		LiteralSearch literals;
+		bool isIn(const QString& text) const
+		{
+			return literals.isSet() ? literals.contains(text) : text.contains(re);
+		}
+	};
+	Pattern pattern(const QString& source) const;
+
+	std::unordered_map<int, Pattern> _match;
+	std::unordered_map<int, Pattern> _notMatch;
+	std::unordered_map<int, double> _min;
+	std::unordered_map<int, double> _max;
+	bool _filterStars=false;
+	QSet<unsigned> _stars;
+	QRegularExpression::PatternOption _caseSensitive=QRegularExpression::CaseInsensitiveOption;
+};
+
+#endif // ROWFILTER_H
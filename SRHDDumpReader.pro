@@ -4,21 +4,10 @@
 #
 #-------------------------------------------------
 
-COMMIT_DATE = $$system(git show -s --pretty='%ci')
-COMMIT_DATE = $$first(COMMIT_DATE)
-COMMIT_HASH = $$system(git log --pretty=format:'%h' -n 1)
-COMMIT_BRANCH =$$system(git branch -a --contains $$COMMIT_HASH | grep -v HEAD | head -n1 | tr / \' \' | awk \'{print $NF}\')
-DEFINES += APP_VERSION=\\\"$$COMMIT_DATE-$$COMMIT_BRANCH-$$COMMIT_HASH\\\"
-CONFIG(release, debug|release): DEFINES+=NDEBUG
+include(core.pri)
 
 RC_FILE = SRHDDumpReader.rc
 
-QT       += core gui
-CONFIG += c++14
-QMAKE_CXXFLAGS += -std=c++14 #-pthread -Wl,--no-as-needed
-QMAKE_LFLAGS += -std=c++14 #-pthread -Wl,--no-as-needed
-
-
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets multimedia
 
 TARGET = SRHDDumpReader
@@ -28,36 +17,34 @@ win32:LIBS += -L"$$_PRO_FILE_PWD_/3rdparty/libs/" -lpsapi
 
 SOURCES += main.cpp\
 	MainWindow.cpp \
-    Equipment.cpp \
-    Ship.cpp \
-    Planet.cpp \
-    BlackHole.cpp \
-    Star.cpp \
-    GoodsArr.cpp \
-    Galaxy.cpp \
     TradeTableModel.cpp \
     HierarchicalHeaderView.cpp \
-    EquipmentTableModel.cpp \
     BlackHolesTableModel.cpp \
-    PlanetsTableModel.cpp \
     FilterHorizontalHeaderView.cpp \
-    SortMultiFilterProxyModel.cpp
+    MapView.cpp \
+    MapTileCache.cpp \
+    MapSaver.cpp \
+    MapOverlay.cpp \
+    TourPlanner.cpp \
+    PriceHistory.cpp \
+    DumpArchive.cpp \
+    DumpIndex.cpp \
+    Pivot.cpp
 
 HEADERS  += MainWindow.h \
-    Equipment.h \
-    Ship.h \
-    Planet.h \
-    BlackHole.h \
-    Star.h \
-    GoodsArr.h \
-    Galaxy.h \
     TradeTableModel.h \
     HierarchicalHeaderView.h \
-    EquipmentTableModel.h \
     BlackHolesTableModel.h \
-    PlanetsTableModel.h \
     FilterHorizontalHeaderView.h \
-    SortMultiFilterProxyModel.h
+    MapView.h \
+    MapTileCache.h \
+    MapSaver.h \
+    MapOverlay.h \
+    TourPlanner.h \
+    PriceHistory.h \
+    DumpArchive.h \
+    DumpIndex.h \
+    Pivot.h
 
 FORMS    += MainWindow.ui
 
@@ -220,4 +207,6 @@ DISTFILES += \
     presets/planets/huge industrial gaal-fei 45p.dr.json \
     presets/planetsReport/huge industrial gaal 30p.dr.json \
     .gitlab-ci.yml \
-    dump2json.sh
+    dump2json.sh \
+    core.pri \
+    SRHDDumpReaderCli.pro
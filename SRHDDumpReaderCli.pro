@@ -0,0 +1,15 @@
+#-------------------------------------------------
+#
+# Headless command line tool: parses dumps and prints reports,
+# scores and preset queries without QtWidgets or a display server.
+#
+#-------------------------------------------------
+
+include(core.pri)
+
+TARGET = SRHDDumpReaderCli
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+SOURCES += mainCli.cpp
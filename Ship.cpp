@@ -46,7 +46,9 @@ Ship::Ship(QTextStream &stream, Galaxy& galaxy, unsigned id, unsigned starId):_i
 			break;
 
 		case 2://Goods
-			_goodsQuantity=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsQuantity=GoodsArr(value);
+			}
 			break;
 
 		case 3://Money
@@ -79,15 +81,21 @@ Ship::Ship(QTextStream &stream, Galaxy& galaxy, unsigned id, unsigned starId):_i
 			break;
 
 		case 8://ShopGoods
-			_goodsShopQuantity=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsShopQuantity=GoodsArr(value);
+			}
 			break;
 
 		case 9://ShopGoodsSale
-			_goodsSale=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsSale=GoodsArr(value);
+			}
 			break;
 
 		case 10://ShopGoodsBuy
-			_goodsBuy=GoodsArr(value);
+			if(galaxy.projection().has(ParseProjection::kMarkets)) {
+				_goodsBuy=GoodsArr(value);
+			}
 			break;
 
 		case 11://IType
@@ -0,0 +1,85 @@
+#include "Skyline.h"
+
+#include <QAbstractItemModel>
+#include <algorithm>
+
+namespace
+{
+// true if a is at least as good as b everywhere and better somewhere
+bool dominates(const double *a, const double *b, int dims)
+{
+	bool better = false;
+	for (int d = 0; d < dims; d++) {
+		if (a[d] < b[d]) {
+			return false;
+		}
+		better |= a[d] > b[d];
+	}
+	return better;
+}
+} // namespace
+
+std::vector<int> Skyline::rows(const QAbstractItemModel &model,
+			       const std::vector<int> &rows,
+			       const QVector<Criterion> &criteria)
+{
+	const int dims = criteria.size();
+	if (dims == 0) {
+		return rows;
+	}
+	// larger is better in every dimension of values
+	std::vector<double> values(rows.size() * dims);
+	for (size_t i = 0; i < rows.size(); i++) {
+		for (int d = 0; d < dims; d++) {
+			const Criterion &c = criteria[d];
+			const double value =
+				model.data(model.index(rows[i], c.col), c.role)
+					.toDouble();
+			values[i * dims + d] = c.larger ? value : -value;
+		}
+	}
+	// the sum of the ranks of the values grows strictly with any of them
+	// and is exact, a row never beats one with a higher score; ranks also
+	// order the infinite distances of tranclucator items and unreachable
+	// stars, where scaling by the range would give NaN
+	std::vector<qint64> score(rows.size(), 0);
+	std::vector<double> sorted(rows.size());
+	for (int d = 0; d < dims; d++) {
+		for (size_t i = 0; i < rows.size(); i++) {
+			sorted[i] = values[i * dims + d];
+		}
+		std::sort(sorted.begin(), sorted.end());
+		sorted.erase(std::unique(sorted.begin(), sorted.end()),
+			     sorted.end());
+		for (size_t i = 0; i < rows.size(); i++) {
+			score[i] += std::lower_bound(sorted.begin(), sorted.end(),
+						     values[i * dims + d])
+				    - sorted.begin();
+		}
+		sorted.resize(rows.size());
+	}
+	std::vector<int> order(rows.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(),
+		  [&](int a, int b) { return score[a] > score[b]; });
+	std::vector<int> frontier;
+	for (int i : order) {
+		const double *row = &values[i * dims];
+		const bool beaten = std::any_of(
+			frontier.begin(), frontier.end(), [&](int f) {
+				return dominates(&values[f * dims], row, dims);
+			});
+		if (!beaten) {
+			frontier.push_back(i);
+		}
+	}
+	std::sort(frontier.begin(), frontier.end());
+	std::vector<int> result;
+	result.reserve(frontier.size());
+	for (int i : frontier) {
+		result.push_back(rows[i]);
+	}
+	return result;
+}
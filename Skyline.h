@@ -0,0 +1,29 @@
+#ifndef SKYLINE_H
+#define SKYLINE_H
+
+#include <Qt>
+#include <QVector>
+#include <vector>
+
+class QAbstractItemModel;
+
+//Rows that no other row beats on every criterion at once, the Pareto
+//frontier. Sort-filter-skyline: the rows are sorted by a score that grows
+//with every criterion, so a row can only be beaten by one before it, and
+//each row is compared with the frontier found so far rather than with all
+//rows.
+namespace Skyline
+{
+struct Criterion
+{
+	int col=0;
+	int role=Qt::DisplayRole;
+	bool larger=true;//larger values are better
+};
+
+//rows of the model, the result keeps their order
+std::vector<int> rows(const QAbstractItemModel& model, const std::vector<int>& rows,
+		      const QVector<Criterion>& criteria);
+}
+
+#endif // SKYLINE_H
@@ -1,4 +1,7 @@
 #include "SortMultiFilterProxyModel.h"
+#include <climits>
+#include <algorithm>
+#include <limits>
 
 SortMultiFilterProxyModel::SortMultiFilterProxyModel(QObject *parent):QSortFilterProxyModel(parent)
 {
@@ -9,75 +12,229 @@ SortMultiFilterProxyModel::SortMultiFilterProxyModel(QObject *parent):QSortFilte
 
 void SortMultiFilterProxyModel::setFilters(const QMap<int, QString> &match, const QMap<int, QString> &notMatch, const QMap<int, double> &min, const QMap<int, double> &max)
 {
-	_match.clear();
-	_notMatch.clear();
-	_min.clear();
-	_max.clear();
-	using MapIntStrCI=QMap<int, QString>::const_iterator;
-	for (MapIntStrCI i = match.begin(); i != match.end(); ++i)
-	{
-		_match[i.key()]=i.value();
+	_filter.setFilters(match,notMatch,min,max);
+	refilter();
+}
+
+void SortMultiFilterProxyModel::setPreset(const QVariantMap &p)
+{
+	_filter.setPreset(p,*sourceModel());
+	_limit=p.value("limit",0).toInt();
+	refilter();
+	sort(p["sortColumn"].toInt(),(Qt::SortOrder)p["sortOrder"].toInt());
+}
+
+void SortMultiFilterProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+	for(const QMetaObject::Connection& connection:_sourceConnections) {
+		disconnect(connection);
 	}
-	for (MapIntStrCI i = notMatch.begin(); i != notMatch.end(); ++i)
-	{
-		_notMatch[i.key()]=i.value();
+	_sourceConnections.clear();
+	//connected before QSortFilterProxyModel, the indexes are dropped
+	//before it filters the changed rows
+	if(model) {
+		auto dropAll=[this](){
+			dropIndexes(0,INT_MAX);
+		};
+		_sourceConnections.push_back(connect(model,&QAbstractItemModel::modelAboutToBeReset,this,dropAll));
+		_sourceConnections.push_back(connect(model,&QAbstractItemModel::rowsInserted,this,dropAll));
+		_sourceConnections.push_back(connect(model,&QAbstractItemModel::rowsRemoved,this,dropAll));
+		_sourceConnections.push_back(connect(model,&QAbstractItemModel::dataChanged,this,
+			[this](const QModelIndex& topLeft, const QModelIndex& bottomRight){
+			dropIndexes(topLeft.column(),bottomRight.column());
+		}));
 	}
+	QSortFilterProxyModel::setSourceModel(model);
+	dropIndexes(0,INT_MAX);
+}
 
-	using MapIntDoubleCI=QMap<int, double>::const_iterator;
-	for (MapIntDoubleCI i = min.begin(); i != min.end(); ++i)
-	{
-		_min[i.key()]=i.value();
+void SortMultiFilterProxyModel::dropIndexes(int firstCol, int lastCol)
+{
+	for(auto i=_bitmaps.begin(); i!=_bitmaps.end(); ++i) {
+		if(i->first>=firstCol && i->first<=lastCol) {
+			i->second.clear();
+			_candidatesDirty=true;
+		}
 	}
-	for (MapIntDoubleCI i = max.begin(); i != max.end(); ++i)
-	{
-		if(i.value()>=_min[i.key()]) {
-			_max[i.key()]=i.value();
+	for(auto i=_trigrams.begin(); i!=_trigrams.end(); ++i) {
+		if(i->first>=firstCol && i->first<=lastCol) {
+			i->second.clear();
+			_candidatesDirty=true;
+		}
+	}
+	for(auto i=_zoneMaps.begin(); i!=_zoneMaps.end(); ++i) {
+		if(i->first>=firstCol && i->first<=lastCol) {
+			i->second.clear();
+			_candidatesDirty=true;
 		}
 	}
-	invalidateFilter();
+	//a row can move on or off the skyline or the top rows while it stays
+	//the same, QSortFilterProxyModel would only filter the changed rows again
+	if(!_skyline.isEmpty() || _limit>0) {
+		_candidatesDirty=true;
+		QTimer::singleShot(0,this,[this](){
+			refilter();
+		});
+	}
+	if(firstCol==0 && lastCol==INT_MAX) {
+		_candidatesDirty=true;
+	}
 }
 
-bool SortMultiFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+const ZoneMap &SortMultiFilterProxyModel::zoneMap(int col) const
 {
-	int colCnt=sourceModel()->columnCount();
-	QVector<QModelIndex> indices;
-	indices.reserve(colCnt);
-	for(int col=0; col<colCnt; col++)
-	{
-		indices.push_back(sourceModel()->index(sourceRow, col, sourceParent));
+	ZoneMap& zoneMap=_zoneMaps[col];
+	if(!zoneMap.isBuilt() && sourceModel()) {
+		zoneMap.build(*sourceModel(),col);
 	}
-	for(const auto& pair:_min)
-	{
-		int col=pair.first;
-		double cellValue=sourceModel()->data(indices[col]).toDouble();
-		if(cellValue<pair.second) {
+	return zoneMap;
+}
+
+bool SortMultiFilterProxyModel::columnRange(int col, double &min, double &max) const
+{
+	double bound;
+	if(!_filter.min(col,bound) && !_filter.max(col,bound)) {
+		auto it=_zoneMaps.find(col);
+		if(it==_zoneMaps.end() || !it->second.isBuilt()) {
 			return false;
 		}
 	}
-	for(const auto& pair:_max)
+	return zoneMap(col).range(min,max);
+}
+
+void SortMultiFilterProxyModel::updateCandidates() const
+{
+	_candidatesDirty=false;
+	_narrowed=false;
+	_limited=false;
+	_answered.clear();
+	const QAbstractItemModel* model=sourceModel();
+	if(!model) {
+		return;
+	}
+	_candidates.assign(model->rowCount(),1);
+	RowBitmap selected;
+	for(int col:_filter.columns())
 	{
-		int col=pair.first;
-		double cellValue=sourceModel()->data(indices[col]).toDouble();
-		if(cellValue>pair.second) {
-			return false;
+		const int type=model->headerData(col,Qt::Horizontal,Qt::UserRole).toInt();
+		if(type==ctInt || type==ctDouble)
+		{
+			double min=-std::numeric_limits<double>::infinity();
+			double max=std::numeric_limits<double>::infinity();
+			const bool hasMin=_filter.min(col,min);
+			const bool hasMax=_filter.max(col,max);
+			if(hasMin || hasMax) {
+				zoneMap(col).narrow(min,max,_candidates);
+				_narrowed=true;
+			}
+			continue;
 		}
+		const QRegularExpression* match=_filter.match(col);
+		const QRegularExpression* notMatch=_filter.notMatch(col);
+		if((!match && !notMatch) || type!=ctString) {
+			continue;
+		}
+		BitmapIndex& bitmaps=_bitmaps[col];
+		if(!bitmaps.isBuilt()) {
+			bitmaps.build(*model,col);
+		}
+		if(bitmaps.isIndexable())
+		{
+			RowBitmap rows=match ? bitmaps.rows(*match) : bitmaps.rows(*notMatch,true);
+			if(match && notMatch) {
+				rows.intersect(bitmaps.rows(*notMatch,true));
+			}
+			if(_answered.isEmpty()) {
+				selected=rows;
+			}
+			else {
+				selected.intersect(rows);
+			}
+			_answered.insert(col);
+			continue;
+		}
+		if(!match) {
+			continue;
+		}
+		TrigramIndex& trigrams=_trigrams[col];
+		if(!trigrams.isBuilt()) {
+			trigrams.build(*model,col);
+		}
+		_narrowed|=trigrams.narrow(*match,_candidates);
 	}
-	for(const auto& pair:_match)
-	{
-		int col=pair.first;
-		const QString& cellValue=sourceModel()->data(indices[col]).toString();
-		if(! cellValue.contains(QRegularExpression(pair.second,_caseSensitive))) {
-			return false;
+	if(!_answered.isEmpty()) {
+		selected.mask(_candidates);
+		_narrowed=true;
+	}
+	_limited=!_skyline.isEmpty() || _limit>0;
+	if(!_limited) {
+		return;
+	}
+	_accepted.clear();
+	for(int row=0; row<int(_candidates.size()); row++) {
+		if(_candidates[row] && _filter.accepts(*model,row,QModelIndex(),_answered)) {
+			_accepted.push_back(row);
 		}
 	}
-	for(const auto& pair:_notMatch)
+	if(!_skyline.isEmpty()) {
+		_accepted=Skyline::rows(*model,_accepted,_skyline);
+	}
+	std::vector<int> kept=_accepted;
+	if(_limit>0 && int(kept.size())>_limit)
 	{
-		int col=pair.first;
-		const QString& cellValue=sourceModel()->data(indices[col]).toString();
-		if(cellValue.contains(QRegularExpression(pair.second,_caseSensitive))) {
-			return false;
-		}
+		//only the rows that are shown are sorted, by QSortFilterProxyModel;
+		//unsorted, the first rows of the source are kept
+		const int col=sortColumn();
+		const bool ascending=sortOrder()==Qt::AscendingOrder;
+		std::nth_element(kept.begin(),kept.begin()+_limit,kept.end(),[&](int a, int b){
+			if(col<0) {
+				return a<b;
+			}
+			const QModelIndex left=model->index(a,col);
+			const QModelIndex right=model->index(b,col);
+			return ascending ? lessThan(left,right) : lessThan(right,left);
+		});
+		kept.resize(_limit);
+	}
+	_candidates.assign(_candidates.size(),0);
+	for(int row:kept) {
+		_candidates[row]=1;
+	}
+	_narrowed=true;
+}
+
+void SortMultiFilterProxyModel::sort(int column, Qt::SortOrder order)
+{
+	const bool changed=column!=sortColumn() || order!=sortOrder();
+	QSortFilterProxyModel::sort(column,order);
+	if(changed && _limit>0) {
+		refilter();
+	}
+}
+
+std::vector<int> SortMultiFilterProxyModel::acceptedRows() const
+{
+	if(_candidatesDirty) {
+		updateCandidates();
 	}
-	return true;
+	if(_limited) {
+		return _accepted;
+	}
+	std::vector<int> rows;
+	for(int row=0; row<rowCount(); row++) {
+		rows.push_back(mapToSource(index(row,0)).row());
+	}
+	std::sort(rows.begin(),rows.end());
+	return rows;
 }
 
+bool SortMultiFilterProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+	if(_candidatesDirty) {
+		updateCandidates();
+	}
+	if(_narrowed && sourceRow<int(_candidates.size()) && !_candidates[sourceRow]) {
+		return false;
+	}
+	return _filter.accepts(*sourceModel(),sourceRow,sourceParent,_answered);
+}
@@ -1,94 +1,135 @@
 #ifndef SORTMULTIFILTERPROXYMODEL_H
 #define SORTMULTIFILTERPROXYMODEL_H
 
-#include <unordered_map>
-
 #include <QSortFilterProxyModel>
 #include <QString>
 #include <QTimer>
-#include <QRegularExpression>
+#include <QVariantMap>
+#include <unordered_map>
+#include <vector>
+
+#include "RowFilter.h"
+#include "TrigramIndex.h"
+#include "BitmapIndex.h"
+#include "ZoneMap.h"
+#include "Skyline.h"
 
 class SortMultiFilterProxyModel : public QSortFilterProxyModel
 {
 	Q_OBJECT
 public:
+	//type of the filter a column supports, reported by the source models in headerData(Qt::UserRole)
+	enum ColumnType {ctString=RowFilter::ctString, ctInt=RowFilter::ctInt,
+			 ctDouble=RowFilter::ctDouble, ctNone=RowFilter::ctNone};
 	explicit SortMultiFilterProxyModel(QObject *parent = 0);
+	//applies a *.dr.json preset the same way FilterHorizontalHeaderView does, but without widgets
+	void setPreset(const QVariantMap& p);
+	const RowFilter& filter() const
+	{
+		return _filter;
+	}
+	//the indexes of the columns are dropped when the source changes
+	void setSourceModel(QAbstractItemModel* model) override;
+	//smallest and largest value of a numeric column of the source, false if
+	//it has no rows or no zone map: they are built the first time a bound
+	//is set on the column, the Route columns plan every route
+	bool columnRange(int col, double& min, double& max) const;
 public slots:
 	void setMin(int col, double min)
 	{
-		if(min==_min[col]) {
-			return;
+		if(_filter.setMin(col,min)) {
+			refilter();
 		}
-		_min[col]=min;
-		correctMinMax(col);
-		invalidateFilter();
 	}
 	void unsetMin(int col)
 	{
-		if(_min.count(col)==0) {
-			return;
+		if(_filter.unsetMin(col)) {
+			refilter();
 		}
-		_min.erase(col);
-		invalidateFilter();
 	}
 	void setMax(int col, double max)
 	{
-		if(_max[col]==max) {
-			return;
+		if(_filter.setMax(col,max)) {
+			refilter();
 		}
-		_max[col]=max;
-		correctMinMax(col);
-		invalidateFilter();
 	}
 	void unsetMax(int col)
 	{
-		if(_max.count(col)==0) {
-			return;
+		if(_filter.unsetMax(col)) {
+			refilter();
 		}
-		_max.erase(col);
-		invalidateFilter();
 	}
 	void setMatch(int col, const QString& match )
 	{
-		if (match.isEmpty()) {
-			unsetMatch(col);
-			return;
+		if(_filter.setMatch(col,match)) {
+			refilter();
 		}
-		if(_match[col]==match) {
-			return;
-		}
-		_match[col]=match;
-		invalidateFilter();
 	}
 	void unsetMatch(int col)
 	{
-		if(_match.count(col)==0) {
-			return;
+		if(_filter.unsetMatch(col)) {
+			refilter();
 		}
-		_match.erase(col);
-		invalidateFilter();
 	}
 	void setNotMatch(int col, const QString& notMatch )
 	{
-		if (notMatch.isEmpty()) {
-			unsetNotMatch(col);
-			return;
+		if(_filter.setNotMatch(col,notMatch)) {
+			refilter();
 		}
-		if(_notMatch[col]==notMatch) {
-			return;
-		}
-		_notMatch[col]=notMatch;
-		invalidateFilter();
-		//std::cout<<"setNotMatch end"<<std::endl;
 	}
 	void unsetNotMatch(int col)
 	{
-		if(_notMatch.count(col)==0) {
-			return;
+		if(_filter.unsetNotMatch(col)) {
+			refilter();
+		}
+	}
+	//rows at one of the stars, the models give the star in data(RowFilter::StarIdRole)
+	void setStars(const QSet<unsigned>& stars)
+	{
+		if(_filter.setStars(stars)) {
+			refilter();
 		}
-		_notMatch.erase(col);
-		invalidateFilter();
 	}
+	void unsetStars()
+	{
+		if(_filter.unsetStars()) {
+			refilter();
+		}
+	}
+	//keeps only the rows of the filter that no other row beats on every
+	//criterion
+	void setSkyline(const QVector<Skyline::Criterion>& criteria)
+	{
+		_skyline=criteria;
+		refilter();
+	}
+	void unsetSkyline()
+	{
+		if(!_skyline.isEmpty()) {
+			_skyline.clear();
+			refilter();
+		}
+	}
+	bool isSkyline() const
+	{
+		return !_skyline.isEmpty();
+	}
+	//top-N mode: only the limit first rows under the current sort are kept,
+	//in the order of the source without one, 0 for all of them
+	void setLimit(int limit)
+	{
+		if(_limit!=limit) {
+			_limit=limit;
+			refilter();
+		}
+	}
+	int limit() const
+	{
+		return _limit;
+	}
+	//source rows the filter and the skyline accept, before the limit, sorted
+	std::vector<int> acceptedRows() const;
+	void sort(int column, Qt::SortOrder order=Qt::AscendingOrder) override;
 	void setFilters(const QMap<int,QString>& match,
 			const QMap<int,QString>& notMatch,
 			const QMap<int,double>& min,
@@ -97,22 +138,31 @@ protected:
 	bool filterAcceptsRow(int sourceRow,
 			      const QModelIndex &sourceParent) const;
 private:
-	void correctMinMax(int col)
-	{
-		if (_min[col]>_max[col] /*|| _max[col]==0.0*/)
-		{
-			if(_max.count(col)==0) {
-				return;
-			}
-			_max.erase(col);
-		}
+	void refilter()
+	{
+		_candidatesDirty=true;
+		invalidateFilter();
 	}
+	//rows the indexes leave to _filter, once per filtering
+	void updateCandidates() const;
+	void dropIndexes(int firstCol, int lastCol);
+	const ZoneMap& zoneMap(int col) const;
 
-	std::unordered_map<int, QString> _match;
-	std::unordered_map<int, QString> _notMatch;
-	std::unordered_map<int, double> _min;
-	std::unordered_map<int, double> _max;
-	QRegularExpression::PatternOption _caseSensitive=QRegularExpression::CaseInsensitiveOption;
+	RowFilter _filter;
+	//by text column, built when it is first filtered: bitmaps if it has a
+	//few values, trigrams otherwise
+	mutable std::unordered_map<int,BitmapIndex> _bitmaps;
+	mutable std::unordered_map<int,TrigramIndex> _trigrams;
+	mutable std::unordered_map<int,ZoneMap> _zoneMaps;//by numeric column
+	mutable std::vector<char> _candidates;
+	mutable bool _candidatesDirty=true;
+	mutable bool _narrowed=false;
+	mutable QSet<int> _answered;//columns the bitmaps answer exactly
+	QVector<Skyline::Criterion> _skyline;
+	int _limit=0;
+	mutable bool _limited=false;//by the skyline or the limit
+	mutable std::vector<int> _accepted;//if _limited
+	std::vector<QMetaObject::Connection> _sourceConnections;
 	//QTimer timer;
 };
 
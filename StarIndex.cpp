@@ -0,0 +1,252 @@
+#include "StarIndex.h"
+
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STARINDEX_SSE2
+#endif
+
+void StarIndex::clear()
+{
+	_ids.clear();
+	_x.clear();
+	_y.clear();
+	_slots.clear();
+	_cellStart.clear();
+	_cellSlots.clear();
+	_built = false;
+	_distances.clear();
+	_lastCenter = -1;
+	_lastDistances = nullptr;
+}
+
+void StarIndex::add(unsigned id, const QPointF &position)
+{
+	auto it = _slots.find(id);
+	if (it != _slots.end()) {
+		_x[it->second] = position.x();
+		_y[it->second] = position.y();
+	} else {
+		_slots[id] = _ids.size();
+		_ids.push_back(id);
+		_x.push_back(position.x());
+		_y.push_back(position.y());
+	}
+	_built = false;
+	_distances.clear();
+	_lastCenter = -1;
+	_lastDistances = nullptr;
+}
+
+void StarIndex::build()
+{
+	_built = false;
+	if (_ids.empty()) {
+		return;
+	}
+	const auto xs = std::minmax_element(_x.begin(), _x.end());
+	const auto ys = std::minmax_element(_y.begin(), _y.end());
+	_left = *xs.first;
+	_top = *ys.first;
+	const double width = std::max(1.0, *xs.second - _left);
+	const double height = std::max(1.0, *ys.second - _top);
+	// about two stars per cell
+	_cellSize = std::max(1.0, std::sqrt(2.0 * width * height / _ids.size()));
+	_cols = int(width / _cellSize) + 1;
+	_rows = int(height / _cellSize) + 1;
+
+	const int count = _ids.size();
+	std::vector<int> cells(count);
+	_cellStart.assign(_cols * _rows + 1, 0);
+	for (int s = 0; s < count; s++) {
+		cells[s] = cellRow(_y[s]) * _cols + cellCol(_x[s]);
+		_cellStart[cells[s] + 1]++;
+	}
+	std::partial_sum(_cellStart.begin(), _cellStart.end(),
+			 _cellStart.begin());
+	std::vector<int> next(_cellStart.begin(), _cellStart.end() - 1);
+	_cellSlots.resize(count);
+	for (int s = 0; s < count; s++) {
+		_cellSlots[next[cells[s]]++] = s;
+	}
+	_built = true;
+}
+
+double StarIndex::distance(unsigned a, unsigned b) const
+{
+	return slotDistance(slot(a), slot(b));
+}
+
+double StarIndex::distanceFrom(unsigned referenceId, unsigned id) const
+{
+	// while parsing the tables would go stale with every star
+	if (!_built) {
+		return distance(referenceId, id);
+	}
+	return distances(slot(referenceId))[slot(id)];
+}
+
+const std::vector<double> &StarIndex::distances(int center) const
+{
+	if (center == _lastCenter) {
+		return *_lastDistances;
+	}
+	auto it = _distances.find(center);
+	if (it == _distances.end()) {
+		// a few references are used at a time
+		if (_distances.size() >= 16) {
+			_distances.clear();
+		}
+		std::vector<double> &d = _distances[center];
+		const int count = _ids.size();
+		d.resize(count);
+		const double x0 = _x[center];
+		const double y0 = _y[center];
+		int s = 0;
+#ifdef STARINDEX_SSE2
+		const __m128d cx = _mm_set1_pd(x0);
+		const __m128d cy = _mm_set1_pd(y0);
+		for (; s + 2 <= count; s += 2) {
+			const __m128d dx = _mm_sub_pd(_mm_loadu_pd(&_x[s]), cx);
+			const __m128d dy = _mm_sub_pd(_mm_loadu_pd(&_y[s]), cy);
+			_mm_storeu_pd(&d[s],
+				      _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+							     _mm_mul_pd(dy, dy))));
+		}
+#endif
+		for (; s < count; s++) {
+			const double dx = _x[s] - x0;
+			const double dy = _y[s] - y0;
+			d[s] = std::sqrt(dx * dx + dy * dy);
+		}
+		it = _distances.find(center);
+	}
+	_lastCenter = center;
+	_lastDistances = &it->second;
+	return it->second;
+}
+
+double StarIndex::slotDistance(int slotA, int slotB) const
+{
+	const double dx = _x[slotA] - _x[slotB];
+	const double dy = _y[slotA] - _y[slotB];
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+int StarIndex::cellCol(double x) const
+{
+	return qBound(0, int(std::floor((x - _left) / _cellSize)), _cols - 1);
+}
+
+int StarIndex::cellRow(double y) const
+{
+	return qBound(0, int(std::floor((y - _top) / _cellSize)), _rows - 1);
+}
+
+bool StarIndex::visitRing(double x, double y, int ring,
+			  const std::function<void(int)> &visit) const
+{
+	const int col0 = cellCol(x);
+	const int row0 = cellRow(y);
+	if (ring > std::max({col0, _cols - 1 - col0, row0, _rows - 1 - row0})) {
+		return false;
+	}
+	for (int row = std::max(0, row0 - ring);
+	     row <= std::min(_rows - 1, row0 + ring); row++) {
+		const bool edgeRow = std::abs(row - row0) == ring;
+		for (int col = std::max(0, col0 - ring);
+		     col <= std::min(_cols - 1, col0 + ring); col++) {
+			// inside the ring was visited before
+			if (!edgeRow && std::abs(col - col0) != ring) {
+				continue;
+			}
+			const int cell = row * _cols + col;
+			for (int i = _cellStart[cell]; i < _cellStart[cell + 1];
+			     i++) {
+				visit(_cellSlots[i]);
+			}
+		}
+	}
+	return true;
+}
+
+std::vector<unsigned> StarIndex::within(unsigned id, double radius) const
+{
+	const int center = slot(id);
+	std::vector<std::pair<double, int>> found;
+	auto check = [&](int s) {
+		const double d = slotDistance(center, s);
+		if (d <= radius) {
+			found.emplace_back(d, s);
+		}
+	};
+	if (!_built) {
+		for (int s = 0; s < int(_ids.size()); s++) {
+			check(s);
+		}
+	} else {
+		const double x = _x[center];
+		const double y = _y[center];
+		for (int row = cellRow(y - radius); row <= cellRow(y + radius);
+		     row++) {
+			for (int col = cellCol(x - radius);
+			     col <= cellCol(x + radius); col++) {
+				const int cell = row * _cols + col;
+				for (int i = _cellStart[cell];
+				     i < _cellStart[cell + 1]; i++) {
+					check(_cellSlots[i]);
+				}
+			}
+		}
+	}
+	std::sort(found.begin(), found.end());
+	std::vector<unsigned> ids;
+	ids.reserve(found.size());
+	for (const auto &pair : found) {
+		ids.push_back(_ids[pair.second]);
+	}
+	return ids;
+}
+
+std::vector<unsigned>
+StarIndex::nearest(unsigned id, unsigned k,
+		   const std::function<bool(unsigned)> &accept) const
+{
+	const int center = slot(id);
+	std::vector<std::pair<double, int>> found;
+	auto check = [&](int s) {
+		if (s != center && (!accept || accept(_ids[s]))) {
+			found.emplace_back(slotDistance(center, s), s);
+		}
+	};
+	if (!_built) {
+		for (int s = 0; s < int(_ids.size()); s++) {
+			check(s);
+		}
+	} else {
+		for (int ring = 0;
+		     visitRing(_x[center], _y[center], ring, check); ring++) {
+			// the stars of the outer rings are at least that far
+			if (k > 0 && found.size() >= k) {
+				std::nth_element(found.begin(),
+						 found.begin() + k - 1,
+						 found.end());
+				if (found[k - 1].first <= ring * _cellSize) {
+					break;
+				}
+			}
+		}
+	}
+	const unsigned n = std::min<size_t>(k, found.size());
+	std::partial_sort(found.begin(), found.begin() + n, found.end());
+	std::vector<unsigned> ids;
+	ids.reserve(n);
+	for (unsigned i = 0; i < n; i++) {
+		ids.push_back(_ids[found[i].second]);
+	}
+	return ids;
+}
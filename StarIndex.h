@@ -0,0 +1,85 @@
+#ifndef STARINDEX_H
+#define STARINDEX_H
+
+#include <QPointF>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+//Positions of the stars in flat arrays, with a uniform grid over them for
+//radius and nearest neighbour queries. Stars are added while the dump is
+//parsed and the grid is built once it is done; until then the queries
+//check every star. Unknown star ids throw std::out_of_range.
+//The distances of all stars from a reference star are computed in one SIMD
+//pass over the coordinates and kept per reference, the cache is not
+//thread-safe.
+class StarIndex
+{
+public:
+	void clear();
+	void add(unsigned id, const QPointF& position);
+	//sorts the stars into the grid, call after the last add()
+	void build();
+
+	unsigned size() const
+	{
+		return _ids.size();
+	}
+	bool contains(unsigned id) const
+	{
+		return _slots.count(id);
+	}
+	//in the order of add()
+	const std::vector<unsigned>& ids() const
+	{
+		return _ids;
+	}
+	QPointF position(unsigned id) const
+	{
+		const int s=slot(id);
+		return QPointF(_x[s],_y[s]);
+	}
+	double distance(unsigned a, unsigned b) const;
+	//same as distance(), read from the table of the reference star
+	double distanceFrom(unsigned referenceId, unsigned id) const;
+	//stars within radius of the star, itself included, nearest first
+	std::vector<unsigned> within(unsigned id, double radius) const;
+	//k stars nearest to the star, itself excluded, that accept() takes
+	std::vector<unsigned> nearest(unsigned id, unsigned k,
+				      const std::function<bool(unsigned)>& accept=nullptr) const;
+
+private:
+	int slot(unsigned id) const
+	{
+		return _slots.at(id);
+	}
+	double slotDistance(int slotA, int slotB) const;
+	//distances of all stars from the star in slot center, by slot
+	const std::vector<double>& distances(int center) const;
+	int cellCol(double x) const;
+	int cellRow(double y) const;
+	//visits the slots in the cells of the square ring at ring cells
+	//from the cell of (x,y), false if the ring is outside the grid
+	bool visitRing(double x, double y, int ring, const std::function<void(int)>& visit) const;
+
+	std::vector<unsigned> _ids;
+	std::vector<double> _x;
+	std::vector<double> _y;
+	std::unordered_map<unsigned,int> _slots;//id -> index into the arrays
+
+	bool _built=false;
+	double _left=0.0;
+	double _top=0.0;
+	double _cellSize=1.0;
+	int _cols=0;
+	int _rows=0;
+	std::vector<int> _cellStart;//_cols*_rows+1 offsets into _cellSlots
+	std::vector<int> _cellSlots;
+
+	//slot of the reference -> distances by slot, filled once built
+	mutable std::unordered_map<int,std::vector<double>> _distances;
+	mutable int _lastCenter=-1;
+	mutable const std::vector<double>* _lastDistances=nullptr;
+};
+
+#endif // STARINDEX_H
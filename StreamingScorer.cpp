@@ -0,0 +1,158 @@
+#include "StreamingScorer.h"
+#include "Report.h"
+
+#include <QFileInfo>
+#include <algorithm>
+
+StreamingScorer::StreamingScorer(const Galaxy *galaxy)
+	: eqModel(galaxy), planetsModel(galaxy)
+{
+}
+
+StreamingScorer::Presets StreamingScorer::loadPresets(
+	const QStringList &planetsPresets, const QStringList &eqPresets)
+{
+	// the filters only read the column types from the headers
+	const EquipmentTableModel eqModel(nullptr);
+	const PlanetsTableModel planetsModel(nullptr);
+	Presets presets;
+	for (const QString &fileName : planetsPresets) {
+		Preset preset;
+		preset.name = QFileInfo(fileName).baseName();
+		preset.filter.setPreset(loadPreset(fileName), planetsModel);
+		presets.planets.push_back(preset);
+	}
+	for (const QString &fileName : eqPresets) {
+		Preset preset;
+		preset.name = QFileInfo(fileName).baseName();
+		preset.filter.setPreset(loadPreset(fileName), eqModel);
+		presets.eq.push_back(preset);
+	}
+	return presets;
+}
+
+void StreamingScorer::setPresets(const Presets &presets)
+{
+	planetsPresets = presets.planets;
+	eqPresets = presets.eq;
+	readsRoutes = false;
+	for (const Preset &preset : planetsPresets) {
+		readsRoutes |= preset.filter.columns().contains(
+			PlanetsTableModel::kRouteColumn);
+	}
+	for (const Preset &preset : eqPresets) {
+		readsRoutes |= preset.filter.columns().contains(
+			EquipmentTableModel::kRouteColumn);
+	}
+}
+
+ParseProjection StreamingScorer::projection() const
+{
+	ParseProjection projection;
+	projection.fields = 0;
+	for (const Preset &preset : eqPresets) {
+		const QSet<int> cols = preset.filter.columns();
+		if (cols.contains(1) || cols.contains(13)) { // Name, Bonus
+			projection.fields |= ParseProjection::kEquipmentNames;
+		}
+	}
+	for (const Preset &preset : planetsPresets) {
+		for (int col : preset.filter.columns()) {
+			// TL0..TL19
+			if (col >= 12 && col < PlanetsTableModel::kRouteColumn) {
+				projection.fields |=
+					ParseProjection::kPlanetTechLevels;
+			}
+		}
+	}
+	return projection;
+}
+
+void StreamingScorer::parseStarted(const Galaxy & /*galaxy*/)
+{
+	pendingEq.clear();
+	pendingPlanets.clear();
+	seenEq = 0;
+	seenPlanets = 0;
+	_summary.clear();
+	_depthList.clear();
+	for (const Preset &preset : planetsPresets) {
+		_summary[preset.name] = 0;
+	}
+	for (const Preset &preset : eqPresets) {
+		_summary[preset.name] = 0;
+		_depthList[preset.name] = QVector<int>();
+	}
+}
+
+void StreamingScorer::starParsed(const Galaxy &galaxy)
+{
+	update(galaxy);
+}
+
+void StreamingScorer::parseFinished(const Galaxy &galaxy)
+{
+	update(galaxy);
+	if (!pendingEq.empty() || !pendingPlanets.empty()) {
+		std::cerr << "StreamingScorer: " << pendingEq.size()
+			  << " items and " << pendingPlanets.size()
+			  << " planets could not be placed" << std::endl;
+	}
+}
+
+void StreamingScorer::update(const Galaxy &galaxy)
+{
+	for (; seenEq < galaxy.equipmentCount(); seenEq++) {
+		pendingEq.push_back(seenEq);
+	}
+	for (; seenPlanets < galaxy.planetCount(); seenPlanets++) {
+		pendingPlanets.push_back(seenPlanets);
+	}
+	// distances are unknown until the star of the player is parsed
+	if (!galaxy.playerStarResolved()) {
+		return;
+	}
+	// the black holes come after the stars
+	if (readsRoutes && !galaxy.routesResolved()) {
+		return;
+	}
+	auto eqEnd = std::remove_if(pendingEq.begin(), pendingEq.end(),
+				    [&](unsigned row) {
+					    if (!galaxy.equipmentResolved(row)) {
+						    return false;
+					    }
+					    countEquipment(galaxy, row);
+					    return true;
+				    });
+	pendingEq.erase(eqEnd, pendingEq.end());
+	auto planetsEnd =
+		std::remove_if(pendingPlanets.begin(), pendingPlanets.end(),
+			       [&](unsigned row) {
+				       if (!galaxy.planetResolved(row)) {
+					       return false;
+				       }
+				       countPlanet(row);
+				       return true;
+			       });
+	pendingPlanets.erase(planetsEnd, pendingPlanets.end());
+}
+
+void StreamingScorer::countEquipment(const Galaxy &galaxy, unsigned row)
+{
+	for (const Preset &preset : eqPresets) {
+		if (preset.filter.accepts(eqModel, row)) {
+			_summary[preset.name]++;
+			_depthList[preset.name].push_back(
+				galaxy.equipmentDepth(row));
+		}
+	}
+}
+
+void StreamingScorer::countPlanet(unsigned row)
+{
+	for (const Preset &preset : planetsPresets) {
+		if (preset.filter.accepts(planetsModel, row)) {
+			_summary[preset.name]++;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef STREAMINGSCORER_H
+#define STREAMINGSCORER_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+#include "Galaxy.h"
+#include "EquipmentTableModel.h"
+#include "PlanetsTableModel.h"
+#include "RowFilter.h"
+
+//Counts the rows of every report preset while the dump is parsed: each item
+//and planet is checked as soon as its star is complete. The summary and the
+//depth lists equal the ones of Report::build(), but are ready the moment
+//parseDump() returns, so scores and isUseless() need no pass over the tables.
+class StreamingScorer : public GalaxyParseObserver
+{
+public:
+	struct Preset
+	{
+		QString name;
+		RowFilter filter;
+	};
+	//the report presets read and compiled, shared by the scorers of many dumps
+	struct Presets
+	{
+		std::vector<Preset> planets;
+		std::vector<Preset> eq;
+	};
+	static Presets loadPresets(const QStringList &planetsPresets, const QStringList &eqPresets);
+
+	explicit StreamingScorer(const Galaxy *galaxy);
+	void setPresets(const Presets &presets);
+	//the fields the presets read, for Galaxy::setProjection()
+	ParseProjection projection() const;
+
+	void parseStarted(const Galaxy &galaxy) override;
+	void starParsed(const Galaxy &galaxy) override;
+	void parseFinished(const Galaxy &galaxy) override;
+
+	const QMap<QString,int>& summary() const
+	{
+		return _summary;
+	}
+	const QMap<QString,QVector<int>>& depthList() const
+	{
+		return _depthList;
+	}
+
+private:
+	void update(const Galaxy &galaxy);
+	void countEquipment(const Galaxy &galaxy, unsigned row);
+	void countPlanet(unsigned row);
+
+	EquipmentTableModel eqModel;
+	PlanetsTableModel planetsModel;
+	std::vector<Preset> planetsPresets;
+	std::vector<Preset> eqPresets;
+
+	//rows are added before their star, they wait here until it is parsed
+	std::vector<unsigned> pendingEq;
+	std::vector<unsigned> pendingPlanets;
+	unsigned seenEq=0;
+	unsigned seenPlanets=0;
+	//a Route column is filtered, the rows wait for the end of the dump
+	bool readsRoutes=false;
+
+	QMap<QString,int> _summary;
+	QMap<QString,QVector<int>> _depthList;
+};
+
+#endif // STREAMINGSCORER_H
@@ -0,0 +1,165 @@
+#include "TourPlanner.h"
+
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+
+TourPlanner::TourPlanner(std::vector<double> distances,
+			 std::vector<double> weights)
+	: _n(weights.size()), _distances(std::move(distances))
+{
+	Q_ASSERT(_distances.size() == size_t((_n + 1) * (_n + 1)));
+	const double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+	_weights.assign(_n + 1, 0.0);
+	for (int i = 0; i < _n; i++) {
+		_weights[i + 1] = sum > 0.0 ? weights[i] / sum : 1.0 / _n;
+	}
+}
+
+double TourPlanner::length(const std::vector<int> &stops) const
+{
+	double travelled = 0.0;
+	int from = 0;
+	for (int stop : stops) {
+		travelled += distance(from, stop);
+		from = stop;
+	}
+	return travelled;
+}
+
+double TourPlanner::cost(const std::vector<int> &stops) const
+{
+	double travelled = 0.0;
+	double arrivals = 0.0;
+	int from = 0;
+	for (int stop : stops) {
+		travelled += distance(from, stop);
+		arrivals += _weights[stop] * travelled;
+		from = stop;
+	}
+	return travelled + arrivals;
+}
+
+std::vector<int> TourPlanner::greedy() const
+{
+	std::vector<int> stops;
+	std::vector<char> visited(_n + 1, 0);
+	int from = 0;
+	for (int i = 0; i < _n; i++) {
+		int next = -1;
+		for (int s = 1; s <= _n; s++) {
+			if (!visited[s]
+			    && (next < 0 || distance(from, s) < distance(from, next))) {
+				next = s;
+			}
+		}
+		visited[next] = 1;
+		stops.push_back(next);
+		from = next;
+	}
+	return stops;
+}
+
+bool TourPlanner::improve(std::vector<int> &stops, double &cost) const
+{
+	// the arrivals make every move change the whole tail, the cost is
+	// evaluated in full; the tours have a few dozen stops
+	const int n = stops.size();
+	std::vector<int> candidate;
+	for (int i = 0; i < n; i++) {
+		for (int j = i + 1; j < n; j++) {
+			candidate = stops;
+			std::reverse(candidate.begin() + i, candidate.begin() + j + 1);
+			const double c = this->cost(candidate);
+			if (c < cost - 1e-9) {
+				stops.swap(candidate);
+				cost = c;
+				return true;
+			}
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		for (int j = 0; j < n; j++) {
+			if (i == j) {
+				continue;
+			}
+			candidate = stops;
+			const int stop = candidate[i];
+			candidate.erase(candidate.begin() + i);
+			candidate.insert(candidate.begin() + j, stop);
+			const double c = this->cost(candidate);
+			if (c < cost - 1e-9) {
+				stops.swap(candidate);
+				cost = c;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+TourPlanner::Tour TourPlanner::search(unsigned seed, int budgetMs) const
+{
+	using Clock = std::chrono::steady_clock;
+	const auto deadline = Clock::now() + std::chrono::milliseconds(budgetMs);
+	std::mt19937 random(seed);
+	std::vector<int> stops = greedy();
+	if (seed > 0) {
+		std::shuffle(stops.begin(), stops.end(), random);
+	}
+	double stopsCost = cost(stops);
+	Tour best;
+	best.stops = stops;
+	best.cost = stopsCost;
+	while (Clock::now() < deadline) {
+		if (improve(stops, stopsCost)) {
+			continue;
+		}
+		if (stopsCost < best.cost) {
+			best.stops = stops;
+			best.cost = stopsCost;
+		}
+		if (_n < 3) {
+			break;
+		}
+		// leaves the local optimum with a double bridge from the best
+		// tour so far
+		stops = best.stops;
+		std::vector<int> cuts(3);
+		std::uniform_int_distribution<int> cut(1, _n - 1);
+		for (int &c : cuts) {
+			c = cut(random);
+		}
+		std::sort(cuts.begin(), cuts.end());
+		std::rotate(stops.begin() + cuts[0], stops.begin() + cuts[1],
+			    stops.begin() + cuts[2]);
+		stopsCost = cost(stops);
+	}
+	if (stopsCost < best.cost) {
+		best.stops = stops;
+		best.cost = stopsCost;
+	}
+	best.length = length(best.stops);
+	return best;
+}
+
+TourPlanner::Tour TourPlanner::solve(int budgetMs) const
+{
+	if (_n == 0) {
+		return Tour();
+	}
+	QVector<unsigned> seeds(std::max(1, QThread::idealThreadCount()));
+	std::iota(seeds.begin(), seeds.end(), 0u);
+	const QVector<Tour> tours = QtConcurrent::blockingMapped<QVector<Tour>>(
+		seeds, [this, budgetMs](unsigned seed) {
+			return search(seed, budgetMs);
+		});
+	return *std::min_element(tours.begin(), tours.end(),
+				 [](const Tour &a, const Tour &b) {
+					 return a.cost < b.cost;
+				 });
+}
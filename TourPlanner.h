@@ -0,0 +1,48 @@
+#ifndef TOURPLANNER_H
+#define TOURPLANNER_H
+
+#include <vector>
+
+//Orders the stops of a trip that starts at the star of the player and does
+//not return. A tour costs its length plus the weighted mean of the distances
+//at which the stops are reached, so the valuable stops come early unless it
+//makes the way much longer. Iterated 2-opt and or-opt from different starts
+//run on all cores until the time is up, the best tour is kept.
+class TourPlanner
+{
+public:
+	struct Tour
+	{
+		std::vector<int> stops;//1..n in the order of the visits
+		double length=0.0;
+		double cost=0.0;
+	};
+
+	//distances from the start (0) and the stops (1..n) to each other, row
+	//by row, (n+1)^2 values; the weights of the stops 1..n, any scale
+	TourPlanner(std::vector<double> distances, std::vector<double> weights);
+	int stopCount() const
+	{
+		return _n;
+	}
+	Tour solve(int budgetMs) const;
+	double length(const std::vector<int>& stops) const;
+	double cost(const std::vector<int>& stops) const;
+
+private:
+	double distance(int from, int to) const
+	{
+		return _distances[from * (_n + 1) + to];
+	}
+	Tour search(unsigned seed, int budgetMs) const;
+	//nearest stop next, the first tour of the search
+	std::vector<int> greedy() const;
+	//first improving 2-opt or or-opt move, false at a local optimum
+	bool improve(std::vector<int>& stops, double& cost) const;
+
+	int _n;
+	std::vector<double> _distances;
+	std::vector<double> _weights;//by stop, 0 for the start, summing to 1
+};
+
+#endif // TOURPLANNER_H
@@ -1,5 +1,7 @@
 #include "TradeTableModel.h"
 #include "HierarchicalHeaderView.h"
+#include "RowFilter.h"
+#include <QFont>
 TradeTableModel::TradeTableModel(const Galaxy *galaxy, QObject *parent) :
     QAbstractTableModel(parent),_galaxy(galaxy)
 {
@@ -13,7 +15,7 @@ int TradeTableModel::rowCount(const QModelIndex &parent) const
 
 int TradeTableModel::columnCount(const QModelIndex &parent) const
 {
-    return 31;//3+8*3+4
+    return 32;//3+8*3+4+1
 }
 
 QVariant TradeTableModel::data(const QModelIndex &index, int role) const
@@ -24,6 +26,29 @@ QVariant TradeTableModel::data(const QModelIndex &index, int role) const
         v.setValue((QObject*)&_horizontalHeaderModel);
         return v;
     }
+    if (role == RowFilter::StarIdRole)
+    {
+        return _galaxy->marketStarId(index.row());
+    }
+    if (role == Qt::ToolTipRole && index.column()==31)
+    {
+        return _galaxy->routeText(_galaxy->referenceStarId(_referenceStar),_galaxy->marketStarId(index.row()));
+    }
+    quint64 marketKey;
+    int good;
+    if (role == Qt::ToolTipRole && _history && goodsCell(index,marketKey,good))
+    {
+        const PriceHistory::Field field=PriceHistory::Field((index.column()-3)%3);
+        const PriceHistory::Trend trend=_history->trend(marketKey,good,field);
+        if(trend.samples<2) {
+            return QVariant();
+        }
+        return tr("%1 on day %2, %3 on day %4; %5 to %6 in %7 dumps, %8 a day")
+                .arg(trend.first).arg(trend.firstDay)
+                .arg(trend.last).arg(trend.lastDay)
+                .arg(trend.min).arg(trend.max).arg(trend.samples)
+                .arg(trend.slope,0,'f',2);
+    }
     if (role == Qt::DisplayRole)
     {
         int col=index.column();
@@ -37,7 +62,7 @@ QVariant TradeTableModel::data(const QModelIndex &index, int role) const
         }
         else if(col==2)
         {
-            return std::round(_galaxy->marketDistFromPlayer(index.row())*10.0)/10.0;
+            return std::round(_galaxy->marketDistance(index.row(),_galaxy->referenceStarId(_referenceStar))*10.0)/10.0;
         }
         else if(col==27)
         {
@@ -55,22 +80,32 @@ QVariant TradeTableModel::data(const QModelIndex &index, int role) const
         {
             return _galaxy->marketPlanetOwner(index.row());
         }
+        else if(col==31)
+        {
+            return std::round(_galaxy->routeDistance(_galaxy->referenceStarId(_referenceStar),_galaxy->marketStarId(index.row()))*10.0)/10.0;
+        }
         else
         {
+            //the goods are read from the packed matrix, not the planets and ships
+            const MarketMatrix& markets=_galaxy->marketMatrix();
+            const unsigned row=index.row();
+            if(row>=markets.size()) {
+                return QVariant();
+            }
             int quantSellBuy=(col-3)%3;
             int goodNum=(col-3)/3;
             switch(quantSellBuy)
             {
             case 0://quantity is requested
-                return _galaxy->marketQuantity(index.row())[goodNum];
+                return markets.quantity(row,goodNum);
                 break;
 
             case 1://sale price is requested
-                return _galaxy->marketSale(index.row())[goodNum];
+                return markets.sale(row,goodNum);
                 break;
 
             case 2://buy price is requested
-                return _galaxy->marketBuy(index.row())[goodNum];
+                return markets.buy(row,goodNum);
                 break;
 
             }
@@ -78,35 +113,37 @@ QVariant TradeTableModel::data(const QModelIndex &index, int role) const
 
         return index.row()+index.column();
     }
+    if (role == Qt::FontRole && _diff)
+    {
+        int col=index.column();
+        if(col>2 && col<27 && (col-3)%3!=0
+           && _diff->priceChanged(DumpDiff::marketKey(*_galaxy,index.row()),(col-3)/3))
+        {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        return QVariant();
+    }
     if (role == Qt::BackgroundColorRole)
     {
         int col=index.column();
-        if(col>2 && col<27)
+        const MarketMatrix& markets=_galaxy->marketMatrix();
+        const unsigned row=index.row();
+        if(col>2 && col<27 && row<markets.size())
         {
             int quantSellBuy=(col-3)%3;
-            if(quantSellBuy==0){
-                return QVariant();
-            }
             int goodNum=(col-3)/3;
-            int maxBuyPrice=_galaxy->maxBuyPrice()[goodNum];
-            int minSellPrice=_galaxy->minSellPrice()[goodNum];
-            int quantity=_galaxy->marketQuantity(index.row())[goodNum];
-            int scale=-1;
+            //the heat of the prices is worked out once per dump
+            QRgb heat=0;
             if(quantSellBuy==1) {
-                int price=_galaxy->marketSale(index.row())[goodNum];
-                if(price>maxBuyPrice || quantity==0) {
-                    return QVariant();
-                }
-                scale=255+255.0*(minSellPrice-price)/(maxBuyPrice-minSellPrice);
-                return QColor(0, 163, 22,std::min(scale,255));
+                heat=markets.saleHeat(row,goodNum);
             }
             else if(quantSellBuy==2) {
-                int price=_galaxy->marketBuy(index.row())[goodNum];
-                if(price<minSellPrice) {
-                    return QVariant();
-                }
-                scale=255.0*(price-minSellPrice)/(maxBuyPrice-minSellPrice);
-                return QColor(0, 116, 224,std::min(scale,255));
+                heat=markets.buyHeat(row,goodNum);
+            }
+            if(heat) {
+                return QColor::fromRgba(heat);
             }
         }
 
@@ -115,6 +152,18 @@ QVariant TradeTableModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
+bool TradeTableModel::goodsCell(const QModelIndex &index, quint64 &marketKey, int &good) const
+{
+    const int col=index.column();
+    if(!index.isValid() || col<3 || col>=27 || unsigned(index.row())>=_galaxy->marketsCount())
+    {
+        return false;
+    }
+    marketKey=DumpDiff::marketKey(*_galaxy,index.row());
+    good=(col-3)/3;
+    return true;
+}
+
 QVariant TradeTableModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     static const QVector<QString> header={tr("Name"),tr("Star"),tr("Dist."),
@@ -126,7 +175,8 @@ QVariant TradeTableModel::headerData(int section, Qt::Orientation orientation, i
                                           tr("Tq"), tr("Ts"), tr("Tb"),
                                           tr("Wq"), tr("Ws"), tr("Wb"),
                                           tr("Dq"), tr("Ds"), tr("Db"),
-                                          tr("Size"),tr("Tech"),tr("Type"),tr("Owner")};
+                                          tr("Size"),tr("Tech"),tr("Type"),tr("Owner"),
+                                          tr("Route")};
     if (role == Qt::DisplayRole)
     {
         if (orientation == Qt::Vertical)
@@ -168,4 +218,11 @@ void TradeTableModel::fillHeaderModel()
 
         _horizontalHeaderModel.setItem(0, prod+3, rootItem);
     }
+
+    //the leaves are counted in order, the columns after the goods follow them
+    static const QVector<QString> planet={tr("Size"),tr("Tech"),tr("Type"),tr("Owner"),tr("Route")};
+    for(int i=0; i<planet.size(); i++)
+    {
+        _horizontalHeaderModel.setItem(0, 11+i, new QStandardItem(planet.at(i)));
+    }
 }
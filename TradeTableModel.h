@@ -4,6 +4,8 @@
 #include <QAbstractTableModel>
 #include <QStandardItemModel>
 #include "Galaxy.h"
+#include "DumpDiff.h"
+#include "PriceHistory.h"
 
 class TradeTableModel : public QAbstractTableModel
 {
@@ -14,6 +16,27 @@ public:
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    //Dist. and Route of the markets from this star, -1 for the star of the player
+    void setReferenceStar(int starId)
+    {
+        _referenceStar=starId;
+        if(rowCount()>0) {
+            emit dataChanged(index(0,2),index(rowCount()-1,2));
+            emit dataChanged(index(0,31),index(rowCount()-1,31));
+        }
+    }
+    //prices changed since the last dump are shown in bold
+    void setDiff(const DumpDiff* diff)
+    {
+        _diff=diff;
+    }
+    //the goods cells tell how their price went over the recorded dumps
+    void setPriceHistory(const PriceHistory* history)
+    {
+        _history=history;
+    }
+    //market and good of a goods cell, false for the other columns
+    bool goodsCell(const QModelIndex& index, quint64& marketKey, int& good) const;
     void reload()
     {
         beginResetModel();
@@ -26,6 +49,9 @@ signals:
 public slots:
 private:
     const Galaxy *_galaxy;
+    int _referenceStar=-1;
+    const DumpDiff* _diff=nullptr;
+    const PriceHistory* _history=nullptr;
     QStandardItemModel _horizontalHeaderModel;
 };
 
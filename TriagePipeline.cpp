@@ -0,0 +1,322 @@
+#include "TriagePipeline.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QtConcurrent>
+
+#include <iostream>
+#include <stdexcept>
+
+QString triageDumpFiles(const QString &dumpFileName, bool keep,
+			const QDateTime &time)
+{
+	QFileInfo fileInfo(dumpFileName);
+	const QString prefix = fileInfo.path() + '/' + fileInfo.completeBaseName();
+	if (!keep) {
+		QFile::remove(prefix + ".txt");
+		QFile::remove(prefix + ".sav");
+		QFile::remove(prefix + ".report");
+		QFile::remove(prefix + "_map.png");
+		return QString();
+	}
+	const QString timestamp = time.toString("yyyyMMdd-hhmmss");
+	QString stamped = prefix + timestamp;
+	// several dumps of the same name kept within a second
+	for (int i = 2; QFileInfo::exists(stamped + ".txt"); i++) {
+		stamped = prefix + timestamp + '_' + QString::number(i);
+	}
+	QFile::rename(prefix + ".txt", stamped + ".txt");
+	QFile::rename(prefix + ".sav", stamped + ".sav_");
+	QFile::rename(prefix + ".report", stamped + ".report");
+	QFile::rename(prefix + "_map.png", stamped + "_map.png");
+	return stamped + ".txt";
+}
+
+bool isTriagedDump(const QString &fileName)
+{
+	static const QRegularExpression stamp("\\d{8}-\\d{6}(_\\d+)?$");
+	return stamp.match(QFileInfo(fileName).completeBaseName()).hasMatch();
+}
+
+TriagePipeline::TriagePipeline(const Settings &settings, QObject *parent)
+	: QObject(parent), _settings(settings),
+	  _presets(StreamingScorer::loadPresets(settings.planetsPresets,
+						settings.eqPresets)),
+	  _pathQueue(settings.queueCapacity), _readQueue(settings.queueCapacity),
+	  _parsedQueue(settings.queueCapacity),
+	  _scoredQueue(settings.queueCapacity)
+{
+	qRegisterMetaType<TriagePipeline::Result>("TriagePipeline::Result");
+	qRegisterMetaType<TriagePipeline::Stats>("TriagePipeline::Stats");
+	// reader, scorer, file actions and the parsers
+	_pool.setMaxThreadCount(3 + std::max(1, _settings.parsers));
+
+	connect(&_watcher, &QFileSystemWatcher::directoryChanged, this,
+		&TriagePipeline::scanDir);
+	// the dumps are written in chunks, a file is taken only once its
+	// size stopped changing between two scans
+	_scanTimer.setInterval(1000);
+	connect(&_scanTimer, &QTimer::timeout, this, &TriagePipeline::scanDir);
+	_statsTimer.setInterval(10000);
+	connect(&_statsTimer, &QTimer::timeout, this,
+		&TriagePipeline::emitStats);
+	connect(this, &TriagePipeline::processed, this,
+		&TriagePipeline::onProcessed, Qt::QueuedConnection);
+}
+
+TriagePipeline::~TriagePipeline()
+{
+	stop();
+}
+
+bool TriagePipeline::start()
+{
+	if (_running || !QFileInfo(_settings.dir).isDir()) {
+		return false;
+	}
+	_running = true;
+	_clock.start();
+	if (!_settings.processExisting) {
+		QDir dir(_settings.dir);
+		const QFileInfoList infoList =
+			dir.entryInfoList(QStringList(_settings.nameFilter),
+					  QDir::Files, QDir::Name);
+		for (const QFileInfo &info : infoList) {
+			_done[info.absoluteFilePath()] = info.lastModified();
+		}
+	}
+	_watcher.addPath(_settings.dir);
+
+	_stages.addFuture(QtConcurrent::run(&_pool, this,
+					    &TriagePipeline::readLoop));
+	_activeParsers = std::max(1, _settings.parsers);
+	for (int i = 0; i < _activeParsers; i++) {
+		_stages.addFuture(QtConcurrent::run(
+			&_pool, this, &TriagePipeline::parseLoop));
+	}
+	_stages.addFuture(QtConcurrent::run(&_pool, this,
+					    &TriagePipeline::scoreLoop));
+	_stages.addFuture(QtConcurrent::run(&_pool, this,
+					    &TriagePipeline::actionLoop));
+	_scanTimer.start();
+	_statsTimer.start();
+	scanDir();
+	return true;
+}
+
+void TriagePipeline::stop()
+{
+	if (!_running) {
+		return;
+	}
+	_running = false;
+	_scanTimer.stop();
+	_statsTimer.stop();
+	_watcher.removePath(_settings.dir);
+	_pathQueue.close();
+	_stages.waitForFinished();
+	_stages.clearFutures();
+}
+
+TriagePipeline::Stats TriagePipeline::stats() const
+{
+	Stats stats = _stats;
+	stats.pending = _pending.size() + _pathQueue.size();
+	stats.read = _readQueue.size();
+	stats.parsed = _parsedQueue.size();
+	stats.scored = _scoredQueue.size();
+	if (!_finishTimes.empty()) {
+		qint64 window = std::min<qint64>(60000, _clock.elapsed());
+		stats.dumpsPerMinute =
+			_finishTimes.size() * 60000.0 / std::max<qint64>(1, window);
+	}
+	return stats;
+}
+
+void TriagePipeline::scanDir()
+{
+	if (!_running) {
+		return;
+	}
+	QDir dir(_settings.dir);
+	const QFileInfoList infoList = dir.entryInfoList(
+		QStringList(_settings.nameFilter), QDir::Files, QDir::Name);
+	QMap<QString, QPair<qint64, QDateTime>> candidates;
+	for (const QFileInfo &info : infoList) {
+		const QString fileName = info.absoluteFilePath();
+		const QDateTime modified = info.lastModified();
+		if (isTriagedDump(fileName) || _inFlight.contains(fileName)
+		    || _pending.contains(fileName)
+		    || _done.value(fileName) == modified) {
+			continue;
+		}
+		QPair<qint64, QDateTime> state(info.size(), modified);
+		if (_candidates.value(fileName) == state) {
+			_pending << fileName;
+		} else {
+			candidates[fileName] = state;
+		}
+	}
+	_candidates = candidates;
+
+	// backpressure: what does not fit stays pending for the next scan
+	while (!_pending.isEmpty() && _pathQueue.tryPush(_pending.first())) {
+		const QString fileName = _pending.takeFirst();
+		_inFlight[fileName] = QFileInfo(fileName).lastModified();
+	}
+}
+
+void TriagePipeline::onProcessed(const TriagePipeline::Result &result)
+{
+	_done[result.fileName] = _inFlight.take(result.fileName);
+	_stats.processed++;
+	if (!result.error.isEmpty()) {
+		_stats.failed++;
+	} else if (result.keep) {
+		_stats.kept++;
+	} else {
+		_stats.discarded++;
+	}
+	const qint64 now = _clock.elapsed();
+	_finishTimes.push_back(now);
+	while (_finishTimes.front() < now - 60000) {
+		_finishTimes.pop_front();
+	}
+	scanDir();
+}
+
+void TriagePipeline::emitStats()
+{
+	emit statsUpdated(stats());
+}
+
+void TriagePipeline::readLoop()
+{
+	QString fileName;
+	while (_pathQueue.pop(fileName)) {
+		ReadDump dump;
+		dump.fileName = fileName;
+		dump.started = _clock.elapsed();
+		if (!readDumpFile(fileName, dump.text)) {
+			dump.text.clear();
+		}
+		_readQueue.push(std::move(dump));
+	}
+	_readQueue.close();
+}
+
+void TriagePipeline::parseLoop()
+{
+	ReadDump dump;
+	while (_readQueue.pop(dump)) {
+		ParsedDump parsed;
+		parsed.fileName = dump.fileName;
+		parsed.started = dump.started;
+		if (dump.text.isEmpty()) {
+			parsed.error = "File could not be open: " + dump.fileName;
+		} else {
+			try {
+				parsed.galaxy.reset(new Galaxy);
+				StreamingScorer scorer(parsed.galaxy.get());
+				scorer.setPresets(_presets);
+				parsed.galaxy->setParseObserver(&scorer);
+				parsed.galaxy->setProjection(scorer.projection());
+				QTextStream stream(&dump.text);
+				parsed.galaxy->parseDump(stream);
+				parsed.galaxy->setParseObserver(nullptr);
+				parsed.summary = scorer.summary();
+				parsed.depthList = scorer.depthList();
+				parsed.keep = !isUseless(parsed.summary,
+							 _settings.minRows);
+			} catch (const std::exception &e) {
+				parsed.galaxy.reset();
+				parsed.error = "Could not parse " + dump.fileName
+					       + ": " + e.what();
+			}
+		}
+		// the report of a discarded dump is deleted anyway
+		if (parsed.galaxy && parsed.keep && !_settings.dryRun) {
+			try {
+				parsed.error =
+					saveReport(dump.fileName, dump.text);
+			} catch (const std::exception &e) {
+				parsed.error = "Could not report " + dump.fileName
+					       + ": " + e.what();
+			}
+		}
+		dump.text.clear();
+		_parsedQueue.push(std::move(parsed));
+	}
+	if (--_activeParsers == 0) {
+		_parsedQueue.close();
+	}
+}
+
+void TriagePipeline::scoreLoop()
+{
+	ParsedDump parsed;
+	while (_parsedQueue.pop(parsed)) {
+		Result result;
+		result.fileName = parsed.fileName;
+		result.error = parsed.error;
+		result.msec = parsed.started;
+		if (parsed.galaxy) {
+			try {
+				Report report(parsed.galaxy.get());
+				report.setScorers(_settings.scorers);
+				report.setSummary(parsed.summary,
+						  parsed.depthList);
+				result.summaryHeader =
+					report.reportSummaryHeader();
+				result.summary = report.reportSummary(false);
+				result.keep = parsed.keep;
+			} catch (const std::exception &e) {
+				result.error = "Could not score "
+					       + parsed.fileName + ": "
+					       + e.what();
+			}
+		}
+		parsed.galaxy.reset();
+		_scoredQueue.push(std::move(result));
+	}
+	_scoredQueue.close();
+}
+
+QString TriagePipeline::saveReport(const QString &fileName,
+				   QString &text) const
+{
+	// the scorer only decoded what the presets read, the report prints
+	// every column
+	Galaxy galaxy;
+	QTextStream stream(&text);
+	galaxy.parseDump(stream);
+	text.clear();
+	Report report(&galaxy);
+	report.setPresets(_settings.planetsPresets, _settings.eqPresets);
+	report.setScorers(_settings.scorers);
+	report.build();
+	QFileInfo fileInfo(fileName);
+	QString reportName =
+		fileInfo.path() + '/' + fileInfo.completeBaseName() + ".report";
+	if (!report.save(reportName)) {
+		return "Could not create the report file " + reportName;
+	}
+	return QString();
+}
+
+void TriagePipeline::actionLoop()
+{
+	Result result;
+	while (_scoredQueue.pop(result)) {
+		// failed dumps are left in place for a human to look at
+		if (result.error.isEmpty() && !_settings.dryRun) {
+			result.newFileName =
+				triageDumpFiles(result.fileName, result.keep);
+		}
+		result.msec = _clock.elapsed() - result.msec;
+		emit processed(result);
+	}
+}
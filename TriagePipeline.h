@@ -0,0 +1,149 @@
+#ifndef TRIAGEPIPELINE_H
+#define TRIAGEPIPELINE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QFutureSynchronizer>
+#include <QMap>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <deque>
+#include <memory>
+
+#include "BoundedQueue.h"
+#include "Galaxy.h"
+#include "Report.h"
+#include "StreamingScorer.h"
+
+//Keeps a dump with its .sav, .report and _map.png (renamed with a timestamp,
+//.sav becomes .sav_) or removes them all, like the galaxy generation does.
+//Returns the new dump file name, empty if the files were removed.
+QString triageDumpFiles(const QString &dumpFileName, bool keep,
+			const QDateTime &time = QDateTime::currentDateTime());
+//true for the dumps already renamed by triageDumpFiles()
+bool isTriagedDump(const QString &fileName);
+
+//Watches a save directory and triages the new dumps:
+//reader -> parser pool -> scorer -> file actions, connected by bounded queues,
+//so a slow stage holds the previous ones instead of buffering whole galaxies.
+//The parsers score the dumps on the fly (StreamingScorer) and decode only the
+//fields the presets read; they parse the kept dumps again in full for their
+//.report files, so the slowest work runs on every parser thread.
+class TriagePipeline : public QObject
+{
+	Q_OBJECT
+public:
+	struct Settings
+	{
+		QString dir;
+		QString nameFilter = "*.txt";
+		QStringList planetsPresets;
+		QStringList eqPresets;
+		QMap<QString, Scorer> scorers;
+		QMap<QString, int> minRows;
+		int parsers = QThread::idealThreadCount();
+		int queueCapacity = 4;
+		bool processExisting = false;
+		bool dryRun = false; //score only, leave the files alone
+	};
+	struct Result
+	{
+		QString fileName;
+		QString newFileName;
+		QString error;
+		QString summaryHeader;
+		QString summary;
+		bool keep = false;
+		qint64 msec = 0; //from reading the file to the file action
+	};
+	struct Stats
+	{
+		//queue depths
+		int pending = 0;
+		int read = 0;
+		int parsed = 0;
+		int scored = 0;
+
+		int processed = 0;
+		int kept = 0;
+		int discarded = 0;
+		int failed = 0;
+		double dumpsPerMinute = 0.0;
+	};
+
+	explicit TriagePipeline(const Settings &settings, QObject *parent = 0);
+	~TriagePipeline();
+	bool start();
+	//finishes the dumps already in the pipeline and returns
+	void stop();
+	Stats stats() const;
+
+signals:
+	void processed(const TriagePipeline::Result &result);
+	void statsUpdated(const TriagePipeline::Stats &stats);
+
+private slots:
+	void scanDir();
+	void onProcessed(const TriagePipeline::Result &result);
+	void emitStats();
+
+private:
+	struct ReadDump
+	{
+		QString fileName;
+		QString text;
+		qint64 started = 0;
+	};
+	struct ParsedDump
+	{
+		QString fileName;
+		std::unique_ptr<Galaxy> galaxy;
+		QMap<QString, int> summary;
+		QMap<QString, QVector<int>> depthList;
+		QString error;
+		bool keep = false;
+		qint64 started = 0;
+	};
+
+	void readLoop();
+	void parseLoop();
+	void scoreLoop();
+	void actionLoop();
+	//parses the text of the dump in full and writes its .report, returns
+	//the error
+	QString saveReport(const QString &fileName, QString &text) const;
+
+	const Settings _settings;
+	const StreamingScorer::Presets _presets; //compiled once for all dumps
+	QFileSystemWatcher _watcher;
+	QTimer _scanTimer;
+	QTimer _statsTimer;
+	QThreadPool _pool;
+	QFutureSynchronizer<void> _stages;
+	bool _running = false;
+
+	BoundedQueue<QString> _pathQueue;
+	BoundedQueue<ReadDump> _readQueue;
+	BoundedQueue<ParsedDump> _parsedQueue;
+	BoundedQueue<Result> _scoredQueue;
+	std::atomic<int> _activeParsers{0};
+
+	//main thread only
+	QMap<QString, QPair<qint64, QDateTime>> _candidates; //size, mtime
+	QMap<QString, QDateTime> _done; //mtime at the time it was triaged
+	QMap<QString, QDateTime> _inFlight;
+	QStringList _pending; //stable files waiting for a free slot
+	QElapsedTimer _clock;
+	std::deque<qint64> _finishTimes; //last minute only
+	Stats _stats;
+};
+
+Q_DECLARE_METATYPE(TriagePipeline::Result)
+Q_DECLARE_METATYPE(TriagePipeline::Stats)
+
+#endif // TRIAGEPIPELINE_H
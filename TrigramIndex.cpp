@@ -0,0 +1,179 @@
+#include "TrigramIndex.h"
+
+#include <QAbstractItemModel>
+#include <algorithm>
+#include <iterator>
+
+void TrigramIndex::build(const QAbstractItemModel &model, int col)
+{
+	clear();
+	const int rowCount = model.rowCount();
+	for (int row = 0; row < rowCount; row++) {
+		const QString text =
+			model.data(model.index(row, col)).toString().toLower();
+		for (int i = 0; i + 3 <= text.size(); i++) {
+			std::vector<int> &rows = _postings[trigram(text.constData() + i)];
+			// a trigram seen twice in a row is listed once
+			if (rows.empty() || rows.back() != row) {
+				rows.push_back(row);
+			}
+		}
+	}
+	_built = true;
+}
+
+std::vector<int> TrigramIndex::rows(const QString &literal) const
+{
+	std::vector<const std::vector<int> *> lists;
+	for (int i = 0; i + 3 <= literal.size(); i++) {
+		auto list = _postings.find(trigram(literal.constData() + i));
+		if (list == _postings.end()) {
+			return std::vector<int>();
+		}
+		lists.push_back(&list->second);
+	}
+	// the rarest trigram first keeps the intersections short
+	std::sort(lists.begin(), lists.end(),
+		  [](const std::vector<int> *a, const std::vector<int> *b) {
+			  return a->size() < b->size();
+		  });
+	std::vector<int> result = *lists.front();
+	std::vector<int> next;
+	for (size_t i = 1; i < lists.size() && !result.empty(); i++) {
+		next.clear();
+		std::set_intersection(result.begin(), result.end(),
+				      lists[i]->begin(), lists[i]->end(),
+				      std::back_inserter(next));
+		result.swap(next);
+	}
+	return result;
+}
+
+QVector<QStringList> TrigramIndex::requiredRuns(const QString &pattern)
+{
+	static const QString escaped = QStringLiteral("^$.*+?()[]{}|\\/-");
+	// escapes with arguments: hex, octal and back references, quoting,
+	// properties, control and named characters; where they end isn't
+	// worth parsing, such a pattern isn't narrowed
+	static const QString longEscapes = QStringLiteral("xocQEpPgkN0123456789");
+	QVector<QStringList> branches(1);
+	for (int i = 0; i + 1 < pattern.size(); i++) {
+		if (pattern[i] == '\\') {
+			if (longEscapes.contains(pattern[++i])) {
+				return branches;
+			}
+		}
+	}
+	QString run;
+	auto endRun = [&]() {
+		if (!run.isEmpty()) {
+			branches.back() << run.toLower();
+			run.clear();
+		}
+	};
+	// skips a group or a class starting at i, nested ones and escapes
+	// included; i ends on its closing character
+	auto skip = [&](int &i) {
+		int depth = 0;
+		bool inClass = false;
+		for (; i < pattern.size(); i++) {
+			const QChar c = pattern[i];
+			if (c == '\\') {
+				i++;
+			} else if (inClass) {
+				if (c == ']') {
+					inClass = false;
+					if (depth == 0) {
+						return;
+					}
+				}
+			} else if (c == '[') {
+				inClass = true;
+			} else if (c == '(') {
+				depth++;
+			} else if (c == ')' && --depth == 0) {
+				return;
+			}
+		}
+	};
+	for (int i = 0; i < pattern.size(); i++) {
+		const QChar c = pattern[i];
+		if (c == '\\' && i + 1 < pattern.size()
+		    && escaped.contains(pattern[i + 1])) {
+			run += pattern[++i];
+		} else if (c == '\\') {
+			// a class like \d or an assertion like \b
+			endRun();
+			i++;
+		} else if (c == '*' || c == '?' || c == '{') {
+			// the character before may be missing
+			run.chop(1);
+			endRun();
+			if (c == '{') {
+				while (i < pattern.size() && pattern[i] != '}') {
+					i++;
+				}
+			}
+		} else if (c == '+') {
+			// the character before is there at least once
+			endRun();
+		} else if (c == '|') {
+			endRun();
+			branches.append(QStringList());
+		} else if (c == '(' || c == '[') {
+			// groups may be optional or alternated, they aren't required
+			endRun();
+			skip(i);
+		} else if (c == '.' || c == '^' || c == '$') {
+			endRun();
+		} else {
+			run += c;
+		}
+	}
+	endRun();
+	return branches;
+}
+
+bool TrigramIndex::narrow(const QRegularExpression &re,
+			  std::vector<char> &rows) const
+{
+	const QVector<QStringList> branches = requiredRuns(re.pattern());
+	std::vector<std::vector<int>> branchRows;
+	for (const QStringList &runs : branches) {
+		std::vector<int> result;
+		bool first = true;
+		for (const QString &run : runs) {
+			if (run.size() < 3) {
+				continue;
+			}
+			std::vector<int> runRows = this->rows(run);
+			if (first) {
+				result.swap(runRows);
+				first = false;
+			} else {
+				std::vector<int> next;
+				std::set_intersection(result.begin(), result.end(),
+						      runRows.begin(), runRows.end(),
+						      std::back_inserter(next));
+				result.swap(next);
+			}
+		}
+		if (first) {
+			// any row may match this branch
+			return false;
+		}
+		branchRows.push_back(std::move(result));
+	}
+	std::vector<char> matching(rows.size(), 0);
+	for (const std::vector<int> &list : branchRows) {
+		for (int row : list) {
+			if (row < int(matching.size())) {
+				matching[row] = 1;
+			}
+		}
+	}
+	for (size_t row = 0; row < rows.size(); row++) {
+		rows[row] &= matching[row];
+	}
+	return true;
+}
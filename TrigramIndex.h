@@ -0,0 +1,50 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+#include <unordered_map>
+#include <vector>
+
+class QAbstractItemModel;
+
+//Rows of a text column by the trigrams of their lowered text. A match filter
+//is turned into a trigram query the way code search engines do it: every
+//branch of a top level alternation needs the literal runs between its
+//metacharacters, "Art.*Hole" the trigrams of "art" and "hole". Only the rows
+//with all of them are left to the regular expression. A branch without a run
+//of three letters can't be answered and needs a full scan.
+class TrigramIndex
+{
+public:
+	void build(const QAbstractItemModel& model, int col);
+	void clear()
+	{
+		_postings.clear();
+		_built=false;
+	}
+	bool isBuilt() const
+	{
+		return _built;
+	}
+	//clears the rows that can't match, false if the pattern isn't indexable
+	bool narrow(const QRegularExpression& re, std::vector<char>& rows) const;
+	//the runs of plain characters every match of a branch contains, lowered,
+	//per branch of the top level alternation; one branch without runs if the
+	//pattern has escapes of more than one character like \x41 or \Q..\E
+	static QVector<QStringList> requiredRuns(const QString& pattern);
+
+private:
+	static quint64 trigram(const QChar* c)
+	{
+		return quint64(c[0].unicode())<<32 | quint64(c[1].unicode())<<16 | c[2].unicode();
+	}
+	//rows with every trigram of the literal, sorted
+	std::vector<int> rows(const QString& literal) const;
+
+	std::unordered_map<quint64,std::vector<int>> _postings;//trigram -> sorted rows
+	bool _built=false;
+};
+
+#endif // TRIGRAMINDEX_H
@@ -0,0 +1,46 @@
+#include "ZoneMap.h"
+
+#include <QAbstractItemModel>
+#include <algorithm>
+
+void ZoneMap::build(const QAbstractItemModel &model, int col)
+{
+	clear();
+	const int rowCount = model.rowCount();
+	for (int row = 0; row < rowCount; row++) {
+		// the same conversion as RowFilter::accepts, so empty cells are 0
+		const double value = model.data(model.index(row, col)).toDouble();
+		if (row % kBlockRows == 0) {
+			_min.push_back(value);
+			_max.push_back(value);
+		} else {
+			_min.back() = std::min(_min.back(), value);
+			_max.back() = std::max(_max.back(), value);
+		}
+	}
+	_built = true;
+}
+
+bool ZoneMap::range(double &min, double &max) const
+{
+	if (_min.empty()) {
+		return false;
+	}
+	min = *std::min_element(_min.begin(), _min.end());
+	max = *std::max_element(_max.begin(), _max.end());
+	return true;
+}
+
+void ZoneMap::narrow(double min, double max, std::vector<char> &rows) const
+{
+	for (size_t block = 0; block < _min.size(); block++) {
+		if (_max[block] >= min && _min[block] <= max) {
+			continue;
+		}
+		const size_t first = block * kBlockRows;
+		const size_t last = std::min(first + kBlockRows, rows.size());
+		for (size_t row = first; row < last; row++) {
+			rows[row] = 0;
+		}
+	}
+}
@@ -0,0 +1,39 @@
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include <vector>
+
+class QAbstractItemModel;
+
+//Smallest and largest value of a numeric column in blocks of rows. The rows
+//come in the order of the dump, by star, so a block is a few neighbouring
+//stars and a range filter like "Dist. at most 20" rules out most blocks
+//without reading their rows.
+class ZoneMap
+{
+public:
+	static const int kBlockRows=256;
+
+	void build(const QAbstractItemModel& model, int col);
+	void clear()
+	{
+		_min.clear();
+		_max.clear();
+		_built=false;
+	}
+	bool isBuilt() const
+	{
+		return _built;
+	}
+	//of the whole column, false if it has no rows
+	bool range(double& min, double& max) const;
+	//clears the rows of the blocks with no value in [min,max]
+	void narrow(double min, double max, std::vector<char>& rows) const;
+
+private:
+	std::vector<double> _min;//by block
+	std::vector<double> _max;
+	bool _built=false;
+};
+
+#endif // ZONEMAP_H
@@ -0,0 +1,68 @@
+# Parser, models and report code shared by the GUI and the command line tool.
+# Must not depend on QtWidgets.
+
+COMMIT_DATE = $$system(git show -s --pretty='%ci')
+COMMIT_DATE = $$first(COMMIT_DATE)
+COMMIT_HASH = $$system(git log --pretty=format:'%h' -n 1)
+COMMIT_BRANCH =$$system(git branch -a --contains $$COMMIT_HASH | grep -v HEAD | head -n1 | tr / \' \' | awk \'{print $NF}\')
+DEFINES += APP_VERSION=\\\"$$COMMIT_DATE-$$COMMIT_BRANCH-$$COMMIT_HASH\\\"
+CONFIG(release, debug|release): DEFINES+=NDEBUG
+
+QT       += core gui concurrent
+CONFIG += c++14
+QMAKE_CXXFLAGS += -std=c++14 #-pthread -Wl,--no-as-needed
+QMAKE_LFLAGS += -std=c++14 #-pthread -Wl,--no-as-needed
+
+SOURCES += \
+    $$PWD/Equipment.cpp \
+    $$PWD/Ship.cpp \
+    $$PWD/Planet.cpp \
+    $$PWD/BlackHole.cpp \
+    $$PWD/Star.cpp \
+    $$PWD/GoodsArr.cpp \
+    $$PWD/MarketMatrix.cpp \
+    $$PWD/StarIndex.cpp \
+    $$PWD/RoutePlanner.cpp \
+    $$PWD/Galaxy.cpp \
+    $$PWD/GalaxyMapRenderer.cpp \
+    $$PWD/DumpDiff.cpp \
+    $$PWD/EquipmentTableModel.cpp \
+    $$PWD/PlanetsTableModel.cpp \
+    $$PWD/RowFilter.cpp \
+    $$PWD/TrigramIndex.cpp \
+    $$PWD/BitmapIndex.cpp \
+    $$PWD/ZoneMap.cpp \
+    $$PWD/LiteralSearch.cpp \
+    $$PWD/Skyline.cpp \
+    $$PWD/SortMultiFilterProxyModel.cpp \
+    $$PWD/Report.cpp \
+    $$PWD/StreamingScorer.cpp \
+    $$PWD/TriagePipeline.cpp
+
+HEADERS += \
+    $$PWD/Equipment.h \
+    $$PWD/Ship.h \
+    $$PWD/Planet.h \
+    $$PWD/BlackHole.h \
+    $$PWD/Star.h \
+    $$PWD/GoodsArr.h \
+    $$PWD/MarketMatrix.h \
+    $$PWD/StarIndex.h \
+    $$PWD/RoutePlanner.h \
+    $$PWD/Galaxy.h \
+    $$PWD/GalaxyMapRenderer.h \
+    $$PWD/DumpDiff.h \
+    $$PWD/EquipmentTableModel.h \
+    $$PWD/PlanetsTableModel.h \
+    $$PWD/RowFilter.h \
+    $$PWD/TrigramIndex.h \
+    $$PWD/BitmapIndex.h \
+    $$PWD/ZoneMap.h \
+    $$PWD/LiteralSearch.h \
+    $$PWD/HashAggregate.h \
+    $$PWD/Skyline.h \
+    $$PWD/SortMultiFilterProxyModel.h \
+    $$PWD/Report.h \
+    $$PWD/StreamingScorer.h \
+    $$PWD/BoundedQueue.h \
+    $$PWD/TriagePipeline.h
@@ -0,0 +1,397 @@
+#include "Galaxy.h"
+#include "Report.h"
+#include "StreamingScorer.h"
+#include "TriagePipeline.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QTimer>
+#include <QTranslator>
+#include <QtConcurrent>
+
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+
+namespace
+{
+
+struct Options {
+	enum Mode { kSummary, kReport, kQuery };
+	Mode mode = kSummary;
+	QStringList planetsPresets;
+	QStringList eqPresets;
+	// compiled once, every dump of the summary mode is scored with them
+	StreamingScorer::Presets presets;
+	QMap<QString, Scorer> scorers;
+	QMap<QString, int> minRows;
+	QVariantMap query;
+	Report::Table table = Report::kEquipment;
+	bool writeReports = false;
+};
+
+struct DumpResult {
+	QString fileName;
+	QString error;
+	QString header;
+	QString output;
+};
+
+QStringList presetFiles(const QString &dirName)
+{
+	QDir dir(dirName);
+	QStringList files = dir.entryList(QDir::Files, QDir::Name);
+	for (QString &str : files) {
+		str = dir.filePath(str);
+	}
+	return files;
+}
+
+QStringList dumpFiles(const QStringList &args)
+{
+	QStringList files;
+	for (const QString &arg : args) {
+		QFileInfo info(arg);
+		if (!info.isDir()) {
+			files << info.absoluteFilePath();
+			continue;
+		}
+		QDir dir(arg);
+		const QFileInfoList infoList = dir.entryInfoList(
+			QStringList("*.txt"), QDir::Files, QDir::Name);
+		for (const QFileInfo &dumpInfo : infoList) {
+			files << dumpInfo.absoluteFilePath();
+		}
+	}
+	return files;
+}
+
+// Parses one dump and renders the requested output. Runs on the pool
+// threads, every call owns its Galaxy and Report.
+class ProcessDump
+{
+public:
+	typedef DumpResult result_type;
+	explicit ProcessDump(const Options &options) : _options(options)
+	{
+	}
+	DumpResult operator()(const QString &fileName) const
+	{
+		DumpResult result;
+		result.fileName = fileName;
+		QString buf;
+		if (!readDumpFile(fileName, buf)) {
+			result.error = "File could not be open: " + fileName;
+			return result;
+		}
+		try {
+			Galaxy galaxy;
+			StreamingScorer scorer(&galaxy);
+			if (_options.mode == Options::kSummary) {
+				scorer.setPresets(_options.presets);
+				galaxy.setParseObserver(&scorer);
+				if (!_options.writeReports) {
+					galaxy.setProjection(scorer.projection());
+				}
+			}
+			QTextStream stream(&buf);
+			galaxy.parseDump(stream);
+			galaxy.setParseObserver(nullptr);
+			buf.clear();
+			Report report(&galaxy);
+			report.setSummary(scorer.summary(), scorer.depthList());
+			if (_options.mode == Options::kQuery) {
+				query(report, result);
+			} else {
+				makeReport(report, result);
+			}
+		} catch (const std::exception &e) {
+			result.error = "Could not parse " + fileName + ": "
+				       + e.what();
+		}
+		return result;
+	}
+
+private:
+	void query(Report &report, DumpResult &result) const
+	{
+		const QString baseName = QFileInfo(result.fileName).baseName();
+		QStringList lines = report.query(_options.query, _options.table)
+					    .split('\n', QString::SkipEmptyParts);
+		if (lines.isEmpty()) {
+			return;
+		}
+		result.header = "dump name\t" + lines.takeFirst();
+		for (const QString &line : lines) {
+			result.output += baseName + '\t' + line + '\n';
+		}
+	}
+	void makeReport(Report &report, DumpResult &result) const
+	{
+		report.setPresets(_options.planetsPresets, _options.eqPresets);
+		report.setScorers(_options.scorers);
+		// the summary mode is already scored during the parse
+		if (_options.mode == Options::kReport || _options.writeReports) {
+			report.build();
+		}
+		if (_options.writeReports) {
+			QFileInfo fileInfo(result.fileName);
+			QString reportName = fileInfo.path() + '/'
+					     + fileInfo.completeBaseName()
+					     + ".report";
+			if (!report.save(reportName)) {
+				result.error = "Could not create the report file "
+					       + reportName;
+			}
+		}
+		if (_options.mode == Options::kReport) {
+			result.output = "# " + result.fileName + '\n'
+					+ report.text();
+			return;
+		}
+		bool useless = isUseless(report.summary(), _options.minRows);
+		result.header = report.reportSummaryHeader() + "verdict";
+		result.output = QFileInfo(result.fileName).baseName() + '\t'
+				+ report.reportSummary(false)
+				+ (useless ? "discard" : "keep") + '\n';
+	}
+
+	const Options &_options;
+};
+
+std::atomic<bool> interrupted(false);
+
+void onInterrupt(int)
+{
+	interrupted = true;
+}
+
+// Runs until Ctrl+C, then lets the dumps already in the pipeline finish.
+int watchDir(QCoreApplication &a, const TriagePipeline::Settings &settings)
+{
+	TriagePipeline pipeline(settings);
+	QTextStream out(stdout);
+	out.setCodec("UTF-8");
+	bool headerPrinted = false;
+	QObject::connect(
+		&pipeline, &TriagePipeline::processed,
+		[&](const TriagePipeline::Result &result) {
+			if (!result.error.isEmpty()) {
+				std::cerr << result.error.toStdString()
+					  << std::endl;
+				return;
+			}
+			if (!headerPrinted) {
+				out << result.summaryHeader << "verdict\tfile\n";
+				headerPrinted = true;
+			}
+			out << QFileInfo(result.fileName).baseName() << '\t'
+			    << result.summary
+			    << (result.keep ? "keep" : "discard") << '\t'
+			    << (settings.dryRun ? result.fileName
+						: result.newFileName)
+			    << endl;
+		});
+	QObject::connect(&pipeline, &TriagePipeline::statsUpdated,
+			 [](const TriagePipeline::Stats &stats) {
+				 std::cerr << "queues: pending " << stats.pending
+					   << ", read " << stats.read
+					   << ", parsed " << stats.parsed
+					   << ", scored " << stats.scored
+					   << "; kept " << stats.kept
+					   << ", discarded " << stats.discarded
+					   << ", failed " << stats.failed << "; "
+					   << stats.dumpsPerMinute
+					   << " dumps/min" << std::endl;
+			 });
+	if (!pipeline.start()) {
+		std::cerr << "Could not watch " << settings.dir.toStdString()
+			  << std::endl;
+		return 2;
+	}
+	std::signal(SIGINT, onInterrupt);
+	std::signal(SIGTERM, onInterrupt);
+	QTimer interruptTimer;
+	QObject::connect(&interruptTimer, &QTimer::timeout, [&a]() {
+		if (interrupted) {
+			a.quit();
+		}
+	});
+	interruptTimer.start(200);
+	a.exec();
+	pipeline.stop();
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	a.setApplicationName("SRHDDumpReaderCli");
+	a.setApplicationVersion(APP_VERSION);
+	QTranslator translator;
+	translator.load("SRHDDumpReader_ru");
+	a.installTranslator(&translator);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(
+		"Parses Space Rangers HD dumps without the GUI and writes "
+		"reports, scorer summaries or preset queries to stdout.\n"
+		"Run it from the directory holding the *.json description "
+		"files, like the GUI.");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addPositionalArgument(
+		"dumps", "Dump files, or directories with *.txt dumps.",
+		"<dump|dir>...");
+	QCommandLineOption modeOption(
+		QStringList() << "m"
+			      << "mode",
+		"summary (default): one scores line per dump; "
+		"report: full report text; "
+		"query: rows matching the --query preset.",
+		"mode", "summary");
+	QCommandLineOption presetsOption(
+		QStringList() << "p"
+			      << "presets",
+		"Presets directory holding planetsReport/ and "
+		"equipmentReport/.",
+		"dir", "presets");
+	QCommandLineOption scorersOption("scorers", "Scorers file.", "file",
+					 "scorers.json");
+	QCommandLineOption minRowsOption(
+		"min-rows", "Minimal rows per preset to keep a dump.", "file",
+		"minRowsPreset.json");
+	QCommandLineOption queryOption(QStringList() << "q"
+						     << "query",
+				       "Preset (*.dr.json) for the query mode.",
+				       "preset");
+	QCommandLineOption tableOption(QStringList() << "t"
+						     << "table",
+				       "Table to query: equipment or planets.",
+				       "table", "equipment");
+	QCommandLineOption threadsOption(
+		QStringList() << "j"
+			      << "threads",
+		"Number of dumps parsed in parallel, all cores by default.",
+		"n");
+	QCommandLineOption watchOption(
+		"watch",
+		"Triage the new dumps appearing in the directory: keep and "
+		"rename, or delete them like the galaxy generation does.",
+		"dir");
+	QCommandLineOption filterOption(
+		"filter", "Dump file name filter for --watch.", "pattern",
+		"*.txt");
+	QCommandLineOption existingOption(
+		"existing", "With --watch also triage the dumps already there.");
+	QCommandLineOption dryRunOption(
+		"dry-run", "With --watch only print the verdicts.");
+	QCommandLineOption queueOption(
+		"queue", "Capacity of every --watch pipeline queue.", "n", "4");
+	QCommandLineOption writeOption(
+		QStringList() << "w"
+			      << "write-reports",
+		"Also write <dump>.report next to every dump.");
+	parser.addOption(modeOption);
+	parser.addOption(presetsOption);
+	parser.addOption(scorersOption);
+	parser.addOption(minRowsOption);
+	parser.addOption(queryOption);
+	parser.addOption(tableOption);
+	parser.addOption(threadsOption);
+	parser.addOption(writeOption);
+	parser.addOption(watchOption);
+	parser.addOption(filterOption);
+	parser.addOption(existingOption);
+	parser.addOption(dryRunOption);
+	parser.addOption(queueOption);
+	parser.process(a);
+
+	Options options;
+	const QString mode = parser.value(modeOption);
+	if (mode == "report") {
+		options.mode = Options::kReport;
+	} else if (mode == "query") {
+		options.mode = Options::kQuery;
+	} else if (mode != "summary") {
+		std::cerr << "Unknown mode: " << mode.toStdString() << std::endl;
+		return 2;
+	}
+	if (options.mode == Options::kQuery) {
+		QString error;
+		options.query = loadPreset(parser.value(queryOption), &error);
+		if (!error.isEmpty()) {
+			std::cerr << error.toStdString() << std::endl;
+			return 2;
+		}
+		if (parser.value(tableOption) == "planets") {
+			options.table = Report::kPlanets;
+		}
+	}
+	const QString presetsDir = parser.value(presetsOption);
+	options.planetsPresets = presetFiles(presetsDir + "/planetsReport/");
+	options.eqPresets = presetFiles(presetsDir + "/equipmentReport/");
+	if (options.mode == Options::kSummary) {
+		options.presets = StreamingScorer::loadPresets(
+			options.planetsPresets, options.eqPresets);
+	}
+	options.scorers = readScorers(parser.value(scorersOption));
+	options.minRows = readMinRowsPreset(parser.value(minRowsOption));
+	options.writeReports = parser.isSet(writeOption);
+	if (parser.isSet(threadsOption)) {
+		QThreadPool::globalInstance()->setMaxThreadCount(
+			std::max(1, parser.value(threadsOption).toInt()));
+	}
+
+	if (parser.isSet(watchOption)) {
+		TriagePipeline::Settings settings;
+		settings.dir = parser.value(watchOption);
+		settings.nameFilter = parser.value(filterOption);
+		settings.planetsPresets = options.planetsPresets;
+		settings.eqPresets = options.eqPresets;
+		settings.scorers = options.scorers;
+		settings.minRows = options.minRows;
+		if (parser.isSet(threadsOption)) {
+			settings.parsers =
+				std::max(1, parser.value(threadsOption).toInt());
+		}
+		settings.queueCapacity =
+			std::max(1, parser.value(queueOption).toInt());
+		settings.processExisting = parser.isSet(existingOption);
+		settings.dryRun = parser.isSet(dryRunOption);
+		return watchDir(a, settings);
+	}
+
+	const QStringList files = dumpFiles(parser.positionalArguments());
+	if (files.isEmpty()) {
+		parser.showHelp(2);
+	}
+
+	const QList<DumpResult> results =
+		QtConcurrent::blockingMapped(files, ProcessDump(options));
+
+	QTextStream out(stdout);
+	out.setCodec("UTF-8");
+	int failed = 0;
+	bool headerPrinted = false;
+	for (const DumpResult &result : results) {
+		if (!result.error.isEmpty()) {
+			std::cerr << result.error.toStdString() << std::endl;
+			++failed;
+		}
+		if (!headerPrinted && !result.header.isEmpty()) {
+			out << result.header << '\n';
+			headerPrinted = true;
+		}
+		out << result.output;
+	}
+	out.flush();
+	return failed ? 1 : 0;
+}